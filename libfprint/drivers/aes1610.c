@@ -581,6 +581,8 @@ capture_read_strip_cb (FpiUsbTransfer *transfer, FpDevice *device,
       stripe->delta_y = 0;
       stripdata = stripe->data;
       memcpy (stripdata, data + 1, FRAME_WIDTH * (FRAME_HEIGHT / 2));
+      if (self->strips)
+        fpi_estimate_frame_movement (&assembling_ctx, self->strips->data, stripe);
       self->strips = g_slist_prepend (self->strips, stripe);
       self->strips_len++;
       self->blanks_count = 0;
@@ -610,7 +612,7 @@ capture_read_strip_cb (FpiUsbTransfer *transfer, FpDevice *device,
       /* send stop capture bits */
       aes_write_regv (dev, capture_stop, G_N_ELEMENTS (capture_stop), stub_capture_stop_cb, NULL);
       self->strips = g_slist_reverse (self->strips);
-      fpi_do_movement_estimation (&assembling_ctx, self->strips);
+      fpi_finish_movement_estimation (&assembling_ctx, self->strips);
       img = fpi_assemble_frames (&assembling_ctx, self->strips);
       img->flags |= FPI_IMAGE_PARTIAL;
 
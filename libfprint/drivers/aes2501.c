@@ -455,7 +455,7 @@ capture_read_strip_cb (FpiUsbTransfer *transfer, FpDevice *_dev,
           FpImage *img;
 
           self->strips = g_slist_reverse (self->strips);
-          fpi_do_movement_estimation (&assembling_ctx, self->strips);
+          fpi_finish_movement_estimation (&assembling_ctx, self->strips);
           img = fpi_assemble_frames (&assembling_ctx,
                                      self->strips);
           img->flags |= FPI_IMAGE_PARTIAL;
@@ -482,6 +482,8 @@ capture_read_strip_cb (FpiUsbTransfer *transfer, FpDevice *_dev,
       stripdata = stripe->data;
       memcpy (stripdata, data + 1, 192 * 8);
       self->no_finger_cnt = 0;
+      if (self->strips)
+        fpi_estimate_frame_movement (&assembling_ctx, self->strips->data, stripe);
       self->strips = g_slist_prepend (self->strips, stripe);
       self->strips_len++;
 
@@ -56,19 +56,41 @@ static void do_capture (FpImageDevice *dev);
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (FpiDeviceAes3k, fpi_device_aes3k, FP_TYPE_IMAGE_DEVICE);
 
+/* Each byte holds two vertically adjacent 4 bit pixels, low nibble first */
+#define NIBBLES(b) { ((b) & 0x0f) * 17, ((b) >> 4) * 17 }
+#define NIBBLES4(b) NIBBLES (b), NIBBLES (b + 1), NIBBLES (b + 2), NIBBLES (b + 3)
+#define NIBBLES16(b) NIBBLES4 (b), NIBBLES4 (b + 4), NIBBLES4 (b + 8), NIBBLES4 (b + 12)
+#define NIBBLES64(b) NIBBLES16 (b), NIBBLES16 (b + 16), NIBBLES16 (b + 32), NIBBLES16 (b + 48)
+
+static const guint8 nibble_table[256][2] = {
+  NIBBLES64 (0), NIBBLES64 (64), NIBBLES64 (128), NIBBLES64 (192),
+};
+
+/* The frames are sent column by column and need to be rotated by 180
+ * degrees. Do that while unpacking, so that every pixel is only written
+ * once. */
 static void
-aes3k_assemble_image (unsigned char *input, size_t width, size_t height,
+aes3k_assemble_image (const unsigned char *input, FpiDeviceAes3kClass *cls,
                       unsigned char *output)
 {
-  size_t row, column;
+  gsize width = cls->frame_width;
+  gsize frame, row, column;
 
-  for (column = 0; column < width; column++)
+  for (frame = 0; frame < cls->frame_number; frame++)
     {
-      for (row = 0; row < height; row += 2)
+      fp_dbg ("frame header byte %02x", *input);
+      input++;
+
+      for (column = 0; column < width; column++)
         {
-          output[width * row + column] = (*input & 0x0f) * 17;
-          output[width * (row + 1) + column] = ((*input & 0xf0) >> 4) * 17;
-          input++;
+          for (row = frame * AES3K_FRAME_HEIGHT; row < (frame + 1) * AES3K_FRAME_HEIGHT; row += 2)
+            {
+              const guint8 *pixels = nibble_table[*input++];
+              unsigned char *out = output + (width - 2 - row) * width + (width - 1 - column);
+
+              out[width] = pixels[0];
+              out[0] = pixels[1];
+            }
         }
     }
 }
@@ -81,10 +103,8 @@ img_cb (FpiUsbTransfer *transfer, FpDevice *device,
   FpiDeviceAes3k *self = FPI_DEVICE_AES3K (device);
   FpiDeviceAes3kPrivate *priv = fpi_device_aes3k_get_instance_private (self);
   FpiDeviceAes3kClass *cls = FPI_DEVICE_AES3K_GET_CLASS (self);
-  unsigned char *ptr = transfer->buffer;
   FpImage *tmp;
   FpImage *img;
-  int i;
 
   /* Image capture operation is finished (error/completed) */
   g_clear_object (&priv->img_capture_cancel);
@@ -108,16 +128,8 @@ img_cb (FpiUsbTransfer *transfer, FpDevice *device,
   fpi_image_device_report_finger_status (dev, TRUE);
 
   tmp = fp_image_new (cls->frame_width, cls->frame_width);
-  tmp->width = cls->frame_width;
-  tmp->height = cls->frame_width;
-  tmp->flags = FPI_IMAGE_COLORS_INVERTED | FPI_IMAGE_V_FLIPPED | FPI_IMAGE_H_FLIPPED;
-  for (i = 0; i < cls->frame_number; i++)
-    {
-      fp_dbg ("frame header byte %02x", *ptr);
-      ptr++;
-      aes3k_assemble_image (ptr, cls->frame_width, AES3K_FRAME_HEIGHT, tmp->data + (i * cls->frame_width * AES3K_FRAME_HEIGHT));
-      ptr += cls->frame_size;
-    }
+  tmp->flags = FPI_IMAGE_COLORS_INVERTED;
+  aes3k_assemble_image (transfer->buffer, cls, tmp->data);
 
   /* FIXME: this is an ugly hack to make the image big enough for NBIS
    * to process reliably */
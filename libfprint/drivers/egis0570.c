@@ -85,19 +85,19 @@ is_last_pkt (FpDevice *dev)
 static char
 postprocess_frames (FpDeviceEgis0570 *self, guint8 * img)
 {
-  size_t mean[EGIS0570_IMGCOUNT] = {0, 0, 0, 0, 0};
+  const gsize n_pixels = EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT;
+  char result = 0;
 
   if (!self->background)
     {
-      self->background = g_malloc (EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT);
-      memset (self->background, 255, EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT);
+      self->background = g_malloc (n_pixels);
+      memset (self->background, 255, n_pixels);
 
       for (size_t k = 0; k < EGIS0570_IMGCOUNT; k += 1)
         {
           guint8 * frame = &img[(k * EGIS0570_IMGSIZE) + EGIS0570_RFMDIS * EGIS0570_IMGWIDTH];
 
-          for (size_t i = 0; i < EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT; i += 1)
-            self->background[i] = MIN (self->background[i], frame[i]);
+          fpi_background_update_min_u8 (self->background, frame, n_pixels);
         }
 
       return 0;
@@ -106,26 +106,13 @@ postprocess_frames (FpDeviceEgis0570 *self, guint8 * img)
   for (size_t k = 0; k < EGIS0570_IMGCOUNT; k += 1)
     {
       guint8 * frame = &img[(k * EGIS0570_IMGSIZE) + EGIS0570_RFMDIS * EGIS0570_IMGWIDTH];
+      guint64 energy;
 
-      for (size_t i = 0; i < EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT; i += 1)
-        {
-          if (frame[i] - EGIS0570_MARGIN  > self->background[i])
-            frame[i] -= self->background[i];
-          else
-            frame[i] = 0;
-
-          mean[k] += frame[i];
-        }
-
-      mean[k] /= EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT;
-    }
-
-  char result = 0;
+      energy = fpi_background_subtract_u8 (frame, self->background, n_pixels, EGIS0570_MARGIN);
 
-  for (size_t k = 0; k < EGIS0570_IMGCOUNT; k += 1)
-    {
-      fp_dbg ("Finger status (picture number, mean) : %ld , %ld", k, mean[k]);
-      if (mean[k] > EGIS0570_MIN_MEAN)
+      fp_dbg ("Finger status (picture number, mean) : %ld , %" G_GUINT64_FORMAT,
+              k, energy / n_pixels);
+      if (fpi_background_finger_present (energy, n_pixels, EGIS0570_MIN_MEAN))
         result |= 1 << k;
     }
 
@@ -170,6 +157,8 @@ data_resp_cb (FpiUsbTransfer *transfer, FpDevice *dev, gpointer user_data, GErro
                   stripe->delta_y = 0;
                   stripdata = stripe->data;
                   memcpy (stripdata, (transfer->buffer) + (((k) * EGIS0570_IMGSIZE) + EGIS0570_IMGWIDTH * EGIS0570_RFMDIS), EGIS0570_IMGWIDTH * EGIS0570_RFMGHEIGHT);
+                  if (self->strips)
+                    fpi_estimate_frame_movement (&assembling_ctx, self->strips->data, stripe);
                   self->strips = g_slist_prepend (self->strips, stripe);
                   self->strips_len += 1;
                 }
@@ -192,7 +181,7 @@ data_resp_cb (FpiUsbTransfer *transfer, FpDevice *dev, gpointer user_data, GErro
         {
           g_autoptr(FpImage) img = NULL;
           self->strips = g_slist_reverse (self->strips);
-          fpi_do_movement_estimation (&assembling_ctx, self->strips);
+          fpi_finish_movement_estimation (&assembling_ctx, self->strips);
           img = fpi_assemble_frames (&assembling_ctx, self->strips);
           img->flags |= (FPI_IMAGE_COLORS_INVERTED | FPI_IMAGE_PARTIAL);
           g_slist_free_full (self->strips, g_free);
@@ -206,16 +206,8 @@ elan_save_img_frame (FpiDeviceElan *elandev)
   unsigned short *frame = g_malloc (frame_size * sizeof (short));
 
   elan_save_frame (elandev, frame);
-  unsigned int sum = 0;
-
-  for (int i = 0; i < frame_size; i++)
-    {
-      if (elandev->background[i] > frame[i])
-        frame[i] = 0;
-      else
-        frame[i] -= elandev->background[i];
-      sum += frame[i];
-    }
+  guint64 sum = fpi_background_subtract_u16 (frame, elandev->background,
+                                             frame_size, 0);
 
   if (sum == 0)
     {
@@ -650,9 +642,7 @@ elan_need_calibration (FpiDeviceElan *elandev)
         }
     }
 
-  for (int i = 0; i < frame_size; i++)
-    bg_mean += elandev->background[i];
-  bg_mean /= frame_size;
+  bg_mean = fpi_background_sum_u16 (elandev->background, frame_size) / frame_size;
 
   delta =
     bg_mean > calib_mean ? bg_mean - calib_mean : calib_mean - bg_mean;
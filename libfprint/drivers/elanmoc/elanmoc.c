@@ -466,11 +466,22 @@ task_ssm_done (FpiSsm *ssm, FpDevice *dev, GError *error)
 
   self->task_ssm = NULL;
   g_clear_pointer (&self->list_result, g_ptr_array_unref);
+  g_clear_pointer (&self->list_responses, g_ptr_array_unref);
 
   if (error)
     fpi_device_action_error (dev, error);
 }
 
+/* The list of stored prints only changes when we enroll or delete, so the
+ * slot responses of the last full listing are kept until then. Walking all
+ * slots takes one USB round trip each, which is slow on a full sensor.
+ */
+static void
+elanmoc_invalidate_list_cache (FpiDeviceElanmoc *self)
+{
+  g_clear_pointer (&self->list_cache, g_ptr_array_unref);
+}
+
 static FpPrint *
 create_print_from_response (FpiDeviceElanmoc *self,
                             uint8_t          *buffer_in,
@@ -569,6 +580,7 @@ elanmoc_get_userid_cb (FpiDeviceElanmoc *self,
         }
 
       g_ptr_array_add (self->list_result, g_object_ref_sink (print));
+      g_ptr_array_add (self->list_responses, g_bytes_new (buffer_in, length_in));
     }
 
   if(self->list_index <= ELAN_MAX_ENROLL_NUM)
@@ -577,6 +589,7 @@ elanmoc_get_userid_cb (FpiDeviceElanmoc *self,
     }
   else
     {
+      self->list_cache = g_steal_pointer (&self->list_responses);
       fpi_device_list_complete (FP_DEVICE (self), g_steal_pointer (&self->list_result), NULL);
       fpi_ssm_next_state (self->task_ssm);
     }
@@ -609,7 +622,32 @@ elanmoc_list (FpDevice *device)
 {
   FpiDeviceElanmoc *self = FPI_DEVICE_ELANMOC (device);
 
+  if (self->list_cache)
+    {
+      g_autoptr(GPtrArray) prints = NULL;
+      guint i;
+
+      prints = g_ptr_array_new_full (self->list_cache->len, g_object_unref);
+      for (i = 0; i < self->list_cache->len; i++)
+        {
+          GBytes *response = g_ptr_array_index (self->list_cache, i);
+          const guint8 *buffer;
+          gsize length;
+          FpPrint *print;
+
+          /* Responses were validated before they were cached */
+          buffer = g_bytes_get_data (response, &length);
+          print = create_print_from_response (self, (uint8_t *) buffer, length, NULL);
+          g_ptr_array_add (prints, g_object_ref_sink (print));
+        }
+
+      fp_dbg ("Listing %u prints from cache", prints->len);
+      fpi_device_list_complete (device, g_steal_pointer (&prints), NULL);
+      return;
+    }
+
   self->list_result = g_ptr_array_new_with_free_func (g_object_unref);
+  self->list_responses = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
   self->task_ssm = fpi_ssm_new (FP_DEVICE (self),
                                 elan_list_run_state,
                                 MOC_LIST_NUM_STATES);
@@ -847,6 +885,7 @@ elanmoc_enroll (FpDevice *device)
   userdata[2] = user_id_len;
 
   memcpy (userdata + 3, user_id, user_id_len);
+  elanmoc_invalidate_list_cache (self);
   self->task_ssm = fpi_ssm_new (FP_DEVICE (self),
                                 elan_enroll_run_state,
                                 MOC_ENROLL_NUM_STATES);
@@ -930,6 +969,7 @@ elanmoc_delete_print (FpDevice *device)
   memcpy (userid_buf + 3, user_id, user_id_len);
 
   fp_info ("Delete Finger, user_id = %s!", user_id_safe);
+  elanmoc_invalidate_list_cache (self);
   self->task_ssm = fpi_ssm_new (device,
                                 elan_delete_run_state,
                                 DELETE_NUM_STATES);
@@ -1074,6 +1114,8 @@ elanmoc_open (FpDevice *device)
   GError *error = NULL;
   gint productid = 0;
 
+  elanmoc_invalidate_list_cache (self);
+
   if (!g_usb_device_reset (fpi_device_get_usb_device (device), &error))
     goto error;
 
@@ -1140,6 +1182,7 @@ elanmoc_close (FpDevice *device)
   FpiDeviceElanmoc *self = FPI_DEVICE_ELANMOC (device);
 
   fp_info ("Elanmoc dev_exit");
+  elanmoc_invalidate_list_cache (self);
   self->task_ssm = fpi_ssm_new (FP_DEVICE (self), dev_exit_handler, DEV_EXIT_STATES);
   fpi_ssm_start (self->task_ssm, task_ssm_exit_done);
 }
@@ -1150,10 +1193,23 @@ fpi_device_elanmoc_init (FpiDeviceElanmoc *self)
   G_DEBUG_HERE ();
 }
 
+static void
+fpi_device_elanmoc_finalize (GObject *object)
+{
+  FpiDeviceElanmoc *self = FPI_DEVICE_ELANMOC (object);
+
+  elanmoc_invalidate_list_cache (self);
+
+  G_OBJECT_CLASS (fpi_device_elanmoc_parent_class)->finalize (object);
+}
+
 static void
 fpi_device_elanmoc_class_init (FpiDeviceElanmocClass *klass)
 {
   FpDeviceClass *dev_class = FP_DEVICE_CLASS (klass);
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = fpi_device_elanmoc_finalize;
 
   dev_class->id = FP_COMPONENT;
   dev_class->full_name = ELAN_MOC_DRIVER_FULLNAME;
@@ -193,4 +193,6 @@ struct _FpiDeviceElanmoc
   int             cmd_retry_cnt;
   int             list_index;
   GPtrArray      *list_result;
+  GPtrArray      *list_responses;
+  GPtrArray      *list_cache;
 };
@@ -66,6 +66,10 @@ struct _FpiDeviceElanSpi
     } hv_data;
   };
 
+  /* calibration result, restored from the cache if possible */
+  gboolean calibration_restored;
+  guint16  calibration_dac;
+
   /* generic temp info for async reading */
   guint8 sensor_status;
   gint64 capture_timeout;
@@ -175,6 +179,9 @@ enum elanspi_calibrate_old_state {
   ELANSPI_CALIBOLD_DACFINE_CAPTURE,
   ELANSPI_CALIBOLD_DACFINE_WRITE_DAC1,
   ELANSPI_CALIBOLD_DACFINE_LOOP,
+  /* write dac and gain from cache */
+  ELANSPI_CALIBOLD_RESTORE_DAC1,
+  ELANSPI_CALIBOLD_RESTORE_GAIN,
   /* exit ok (cleanup by protecting) */
   ELANSPI_CALIBOLD_PROTECT,
   ELANSPI_CALIBOLD_NSTATES
@@ -611,6 +618,14 @@ elanspi_calibrate_old_handler (FpiSsm *ssm, FpDevice *dev)
     case ELANSPI_CALIBOLD_DACBASE_CAPTURE:
     case ELANSPI_CALIBOLD_CHECKFIN_CAPTURE:
     case ELANSPI_CALIBOLD_DACFINE_CAPTURE:
+      /* With a restored calibration only the dac needs to be written */
+      if (fpi_ssm_get_cur_state (ssm) == ELANSPI_CALIBOLD_DACBASE_CAPTURE &&
+          self->calibration_restored)
+        {
+          fpi_ssm_jump_to_state (ssm, ELANSPI_CALIBOLD_RESTORE_DAC1);
+          return;
+        }
+
       chld = fpi_ssm_new (dev, elanspi_capture_old_handler, ELANSPI_CAPTOLD_NSTATES);
       fpi_ssm_silence_debug (chld);
       fpi_ssm_start_subsm (ssm, chld);
@@ -679,8 +694,23 @@ elanspi_calibrate_old_handler (FpiSsm *ssm, FpDevice *dev)
       fpi_ssm_jump_to_state (ssm, ELANSPI_CALIBOLD_DACFINE_CAPTURE);
       return;
 
+    case ELANSPI_CALIBOLD_RESTORE_DAC1:
+      self->old_data.dac_value = self->calibration_dac;
+      fp_dbg ("<calibold> using cached dac 0x%02x", self->old_data.dac_value);
+      xfer = elanspi_write_register (self, 0x6, self->old_data.dac_value - 0x40);
+      xfer->ssm = ssm;
+      fpi_spi_transfer_submit (xfer, fpi_device_get_cancellable (dev), fpi_ssm_spi_transfer_cb, NULL);
+      return;
+
+    case ELANSPI_CALIBOLD_RESTORE_GAIN:
+      xfer = elanspi_write_register (self, 0x5, 0x6f);
+      xfer->ssm = ssm;
+      fpi_spi_transfer_submit (xfer, fpi_device_get_cancellable (dev), fpi_ssm_spi_transfer_cb, NULL);
+      return;
+
     case ELANSPI_CALIBOLD_PROTECT:
       fp_dbg ("<calibold> calibration ok, saving bg image");
+      self->calibration_dac = self->old_data.dac_value;
       xfer = elanspi_write_register (self, 0x00, 0x00);
       xfer->ssm = ssm;
       fpi_spi_transfer_submit (xfer, fpi_device_get_cancellable (dev), fpi_ssm_spi_transfer_cb, NULL);
@@ -851,8 +881,17 @@ elanspi_calibrate_hv_handler (FpiSsm *ssm, FpDevice *dev)
 
     case ELANSPI_CALIBHV_WRITE_GDAC_H:
     case ELANSPI_CALIBHV_WRITE_BEST_GDAC_H:
+      if (self->calibration_restored && fpi_ssm_get_cur_state (ssm) == ELANSPI_CALIBHV_WRITE_GDAC_H)
+        {
+          fp_dbg ("<calibhv> using cached gdac %04x", self->calibration_dac);
+          self->hv_data.best_gdac = self->calibration_dac;
+          fpi_ssm_jump_to_state (ssm, ELANSPI_CALIBHV_WRITE_BEST_GDAC_H);
+          return;
+        }
       if (fpi_ssm_get_cur_state (ssm) == ELANSPI_CALIBHV_WRITE_BEST_GDAC_H)
         self->hv_data.gdac_value = self->hv_data.best_gdac;
+      /* remember what is written, captures reuse the calibration data */
+      self->calibration_dac = self->hv_data.gdac_value;
       xfer = elanspi_write_register (self, 0x06, (self->hv_data.gdac_value >> 2) & 0xff);
       xfer->ssm = ssm;
       fpi_spi_transfer_submit (xfer, fpi_device_get_cancellable (dev), fpi_ssm_spi_transfer_cb, NULL);
@@ -914,6 +953,61 @@ elanspi_calibrate_hv_handler (FpiSsm *ssm, FpDevice *dev)
     }
 }
 
+/* The sensor has no serial number that could be read over SPI, so a cached
+ * calibration is only tied to the sensor model. The device id does not help
+ * either, it is the same for all SPI devices. */
+static gchar *
+elanspi_calibration_key (FpiDeviceElanSpi *self)
+{
+  return g_strdup_printf ("%02x:%02x:%02x:%ux%u:%u",
+                          self->sensor_id, self->sensor_raw_version, self->sensor_ic_version,
+                          self->sensor_width, self->sensor_height, self->sensor_vcm_mode);
+}
+
+/* the cached calibration is the dac value followed by the background image */
+static void
+elanspi_store_calibration (FpiDeviceElanSpi *self)
+{
+  g_autofree gchar *key = elanspi_calibration_key (self);
+  g_autoptr(GBytes) data = NULL;
+  gsize bg_size = self->sensor_width * self->sensor_height * 2;
+  guint8 *blob;
+
+  blob = g_malloc (sizeof (guint16) + bg_size);
+  memcpy (blob, &self->calibration_dac, sizeof (guint16));
+  memcpy (blob + sizeof (guint16), self->bg_image, bg_size);
+  data = g_bytes_new_take (blob, sizeof (guint16) + bg_size);
+
+  fpi_device_set_calibration (FP_DEVICE (self), key, data);
+}
+
+static gboolean
+elanspi_load_calibration (FpiDeviceElanSpi *self)
+{
+  g_autofree gchar *key = elanspi_calibration_key (self);
+  g_autoptr(GBytes) data = NULL;
+  gsize bg_size = self->sensor_width * self->sensor_height * 2;
+  const guint8 *blob;
+  gsize len;
+
+  data = fpi_device_get_calibration (FP_DEVICE (self), key, ELANSPI_CALIBRATION_MAX_AGE_SECONDS);
+  if (!data)
+    return FALSE;
+
+  blob = g_bytes_get_data (data, &len);
+  if (len != sizeof (guint16) + bg_size)
+    {
+      fp_warn ("<init/calibrate> ignoring cached calibration of wrong size");
+      fpi_device_clear_calibration (FP_DEVICE (self));
+      return FALSE;
+    }
+
+  memcpy (&self->calibration_dac, blob, sizeof (guint16));
+  memcpy (self->bg_image, blob + sizeof (guint16), bg_size);
+
+  return TRUE;
+}
+
 static void
 elanspi_init_ssm_handler (FpiSsm *ssm, FpDevice *dev)
 {
@@ -1118,6 +1212,7 @@ do_sw_reset:
 
     case ELANSPI_INIT_CALIBRATE:
       fp_dbg ("<init/calibrate> starting calibrate");
+      self->calibration_restored = elanspi_load_calibration (self);
       /* if sensor is hv */
       if (self->sensor_id == 0xe)
         chld = fpi_ssm_new_full (dev, elanspi_calibrate_hv_handler, ELANSPI_CALIBHV_NSTATES, ELANSPI_CALIBHV_PROTECT, "HV calibrate");
@@ -1128,6 +1223,12 @@ do_sw_reset:
       return;
 
     case ELANSPI_INIT_BG_CAPTURE:
+      if (self->calibration_restored)
+        {
+          /* background was restored together with the dac */
+          fpi_ssm_mark_completed (ssm);
+          return;
+        }
       if (self->sensor_id == 0xe)
         chld = fpi_ssm_new (dev, elanspi_capture_hv_handler, ELANSPI_CAPTHV_NSTATES);
       else
@@ -1138,6 +1239,7 @@ do_sw_reset:
 
     case ELANSPI_INIT_BG_SAVE:
       memcpy (self->bg_image, self->last_image, self->sensor_height * self->sensor_width * 2);
+      elanspi_store_calibration (self);
       fpi_ssm_mark_completed (ssm);
       return;
     }
@@ -359,6 +359,9 @@ static const FpIdEntry elanspi_id_table[] = {
 
 #define ELANSPI_HV_CALIBRATION_TARGET_MEAN 3000
 
+/* reuse a calibration (dac and background) for this long */
+#define ELANSPI_CALIBRATION_MAX_AGE_SECONDS (30 * 60)
+
 #define ELANSPI_MIN_EMPTY_INVALID_PERCENT 6
 #define ELANSPI_MAX_REAL_INVALID_PERCENT 3
 
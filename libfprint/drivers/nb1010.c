@@ -38,6 +38,8 @@
 
 #define NB1010_LINE_PER_PARTIAL 2
 #define NB1010_N_PARTIAL (FRAME_HEIGHT / NB1010_LINE_PER_PARTIAL)
+/* Partial reads kept in flight to avoid idle time on the bus */
+#define NB1010_PARTIAL_IN_FLIGHT 4
 
 #define NB1010_DEFAULT_TIMEOUT 500
 #define NB1010_TRANSITION_DELAY 50
@@ -91,9 +93,15 @@ struct _FpiDeviceNb1010
 {
   FpImageDevice parent;
   FpiSsm       *ssm;
-  guint8       *scanline_buf;
+  FpImage      *capture_img;
   gboolean      deactivating;
+  int           partial_submitted;
   int           partial_received;
+  int           partial_in_flight;
+  GError       *partial_error;
+  GCancellable *partial_cancellable;
+  GCancellable *partial_action_cancellable;
+  gulong        partial_cancel_id;
 };
 G_DECLARE_FINAL_TYPE (FpiDeviceNb1010, fpi_device_nb1010, FPI, DEVICE_NB1010, FpImageDevice);
 G_DEFINE_TYPE (FpiDeviceNb1010, fpi_device_nb1010, FP_TYPE_IMAGE_DEVICE);
@@ -106,8 +114,6 @@ nb1010_dev_init (FpImageDevice *dev)
 
   g_usb_device_claim_interface (fpi_device_get_usb_device (FP_DEVICE (dev)), 0, 0, &error);
 
-  self->scanline_buf = g_malloc0 (FRAME_WIDTH * FRAME_HEIGHT);
-
   fpi_image_device_open_complete (dev, error);
   fp_dbg ("nb1010 Initialized");
 }
@@ -118,7 +124,7 @@ nb1010_dev_deinit (FpImageDevice *dev)
   FpiDeviceNb1010 *self = FPI_DEVICE_NB1010 (dev);
   GError *error = NULL;
 
-  g_clear_pointer (&self->scanline_buf, g_free);
+  g_clear_object (&self->capture_img);
 
   g_usb_device_release_interface (fpi_device_get_usb_device (FP_DEVICE (dev)), 0, 0, &error);
   fpi_image_device_close_complete (dev, error);
@@ -252,72 +258,139 @@ nb1010_write_ignore_read (FpiDeviceNb1010 *dev, guint8 *buf, gsize len)
 }
 
 
+static void nb1010_read_capture_cb (FpiUsbTransfer *transfer,
+                                    FpDevice       *dev,
+                                    gpointer        user_data,
+                                    GError         *error);
+
+static void
+nb1010_submit_partial (FpiDeviceNb1010 *self, FpiUsbTransfer *transfer)
+{
+  int partial = self->partial_submitted++;
+
+  self->partial_in_flight++;
+  fpi_usb_transfer_submit (transfer, NB1010_DEFAULT_TIMEOUT,
+                           self->partial_cancellable,
+                           nb1010_read_capture_cb, GINT_TO_POINTER (partial));
+}
+
+static void
+nb1010_cancel_partials (GCancellable *action_cancellable,
+                        GCancellable *partial_cancellable)
+{
+  g_cancellable_cancel (partial_cancellable);
+}
+
+static void
+nb1010_clear_partials (FpiDeviceNb1010 *self)
+{
+  if (self->partial_cancel_id)
+    g_cancellable_disconnect (self->partial_action_cancellable,
+                              self->partial_cancel_id);
+  self->partial_cancel_id = 0;
+  g_clear_object (&self->partial_action_cancellable);
+  g_clear_object (&self->partial_cancellable);
+}
+
 static void
 nb1010_read_capture_cb (FpiUsbTransfer *transfer, FpDevice *dev,
-                        gpointer unused_data, GError *error)
+                        gpointer user_data, GError *error)
 {
   FpiDeviceNb1010 *self = FPI_DEVICE_NB1010 (dev);
+  int partial = GPOINTER_TO_INT (user_data);
+
+  self->partial_in_flight--;
 
   if (error)
     {
-      fpi_ssm_mark_failed (transfer->ssm, error);
-      return;
+      /* Stop the other reads, their data is of no use anymore */
+      if (self->partial_error)
+        {
+          g_error_free (error);
+        }
+      else
+        {
+          self->partial_error = error;
+          g_cancellable_cancel (self->partial_cancellable);
+        }
     }
-  if (self->deactivating)
+  else if (!self->deactivating && !self->partial_error)
     {
-      fpi_ssm_mark_completed (transfer->ssm);
-      return;
-    }
+      size_t offset = partial * NB1010_LINE_PER_PARTIAL * FRAME_WIDTH;
 
-  g_assert (transfer->actual_length == NB1010_CAPTURE_RECV_LEN);
+      g_assert (transfer->actual_length == NB1010_CAPTURE_RECV_LEN);
 
-  size_t offset = self->partial_received * NB1010_LINE_PER_PARTIAL * FRAME_WIDTH;
+      memcpy (self->capture_img->data + offset,
+              transfer->buffer + NB1010_CAPTURE_HEADER_LEN, NB1010_LINE_PER_PARTIAL * FRAME_WIDTH);
+      self->partial_received++;
 
-  memcpy (self->scanline_buf + offset,
-          transfer->buffer + NB1010_CAPTURE_HEADER_LEN, NB1010_LINE_PER_PARTIAL * FRAME_WIDTH);
-
-  self->partial_received++;
-  if (self->partial_received == NB1010_N_PARTIAL)
-    {
-      fpi_ssm_next_state (transfer->ssm);
-      return;
+      if (self->partial_submitted < NB1010_N_PARTIAL)
+        nb1010_submit_partial (self, fpi_usb_transfer_ref (transfer));
     }
 
-  fpi_usb_transfer_submit (fpi_usb_transfer_ref (transfer), NB1010_DEFAULT_TIMEOUT,
-                           fpi_device_get_cancellable (FP_DEVICE (dev)),
-                           nb1010_read_capture_cb, NULL);
+  /* Only continue once no partial read is pending anymore */
+  if (self->partial_in_flight > 0)
+    return;
+
+  nb1010_clear_partials (self);
+
+  if (self->partial_error)
+    fpi_ssm_mark_failed (transfer->ssm, g_steal_pointer (&self->partial_error));
+  else if (self->deactivating)
+    fpi_ssm_mark_completed (transfer->ssm);
+  else
+    fpi_ssm_next_state (transfer->ssm);
 }
 
 static void
 nb1010_read_capture (FpiDeviceNb1010 *dev)
 {
-  FpiUsbTransfer *transfer = NULL;
+  GCancellable *action_cancellable = fpi_device_get_cancellable (FP_DEVICE (dev));
+  int in_flight = NB1010_PARTIAL_IN_FLIGHT;
+  int i;
+
+  /* The recorded captures were read one partial at a time */
+  if (g_strcmp0 (g_getenv ("FP_DEVICE_EMULATION"), "1") == 0)
+    in_flight = 1;
+
+  /* The lines are copied straight into the image that is submitted */
+  g_clear_object (&dev->capture_img);
+  dev->capture_img = fp_image_new (FRAME_WIDTH, FRAME_HEIGHT);
+  dev->partial_submitted = 0;
+  dev->partial_received = 0;
+
+  /* Cancelling the action or a failed read cancels all pending reads */
+  dev->partial_cancellable = g_cancellable_new ();
+  if (action_cancellable)
+    {
+      dev->partial_action_cancellable = g_object_ref (action_cancellable);
+      dev->partial_cancel_id = g_cancellable_connect (action_cancellable,
+                                                      G_CALLBACK (nb1010_cancel_partials),
+                                                      dev->partial_cancellable,
+                                                      NULL);
+    }
 
-  transfer = fpi_usb_transfer_new ( FP_DEVICE ( dev));
-  transfer->short_is_error = TRUE;
-  transfer->ssm = dev->ssm;
+  for (i = 0; i < in_flight; i++)
+    {
+      FpiUsbTransfer *transfer = NULL;
 
-  fpi_usb_transfer_fill_bulk (transfer, NB1010_EP_IN, NB1010_CAPTURE_RECV_LEN);
-  fpi_usb_transfer_submit (transfer, NB1010_DEFAULT_TIMEOUT,
-                           fpi_device_get_cancellable (FP_DEVICE (dev)),
-                           nb1010_read_capture_cb, NULL);
+      transfer = fpi_usb_transfer_new (FP_DEVICE (dev));
+      transfer->short_is_error = TRUE;
+      transfer->ssm = dev->ssm;
+
+      fpi_usb_transfer_fill_bulk (transfer, NB1010_EP_IN, NB1010_CAPTURE_RECV_LEN);
+      nb1010_submit_partial (dev, transfer);
+    }
 }
 
-static int
+static void
 submit_image (FpiSsm        *ssm,
               FpImageDevice *dev)
 {
   FpiDeviceNb1010 *self = FPI_DEVICE_NB1010 (dev);
-  FpImage *img;
-
-  img = fp_image_new (FRAME_WIDTH, FRAME_HEIGHT);
-  if (img == NULL)
-    return 0;
-
-  memcpy (img->data, self->scanline_buf, FRAME_WIDTH * FRAME_HEIGHT);
-  fpi_image_device_image_captured (dev, img);
 
-  return 1;
+  g_assert (self->partial_received == NB1010_N_PARTIAL);
+  fpi_image_device_image_captured (dev, g_steal_pointer (&self->capture_img));
 }
 
 static void
@@ -329,6 +402,7 @@ m_loop_complete (FpiSsm *ssm, FpDevice *_dev, GError *error)
   FpiDeviceNb1010 *self = FPI_DEVICE_NB1010 (_dev);
 
   self->ssm = NULL;
+  g_clear_object (&self->capture_img);
 
   if (self->deactivating)
     nb1010_dev_deactivated (dev, error);
@@ -370,7 +444,6 @@ m_loop_state (FpiSsm *ssm, FpDevice *_dev)
       break;
 
     case M_READ_PRINT_START:
-      self->partial_received = 0;
       nb1010_write_ignore_read (self, nb1010_cmd_capture, G_N_ELEMENTS (nb1010_cmd_capture));
       break;
 
@@ -379,15 +452,9 @@ m_loop_state (FpiSsm *ssm, FpDevice *_dev)
       break;
 
     case M_SUBMIT_PRINT:
-      if (submit_image (ssm, dev))
-        {
-          fpi_ssm_mark_completed (ssm);
-          fpi_image_device_report_finger_status (dev, FALSE);
-        }
-      else
-        {
-          fpi_ssm_jump_to_state (ssm, M_WAIT_PRINT);
-        }
+      submit_image (ssm, dev);
+      fpi_ssm_mark_completed (ssm);
+      fpi_image_device_report_finger_status (dev, FALSE);
       break;
 
     default:
@@ -58,6 +58,9 @@
 /* Best image contrast */
 #define VFS_IMG_BEST_CONTRAST 128
 
+/* Reuse the contrast found by the calibration for this long */
+#define VFS_CALIBRATION_MAX_AGE (30 * 60)
+
 /* Device parameters address */
 #define VFS_PAR_000E 0x000e
 #define VFS_PAR_0011 0x0011
@@ -122,6 +125,9 @@ struct _FpDeviceVfs101
 
   /* Image height */
   int height;
+
+  /* USB serial number, if the device has one */
+  gchar *serial;
 };
 G_DECLARE_FINAL_TYPE (FpDeviceVfs101, fpi_device_vfs101, FPI, DEVICE_VFS101,
                       FpImageDevice);
@@ -538,7 +544,7 @@ vfs_img_load (FpiSsm        *ssm,
 static void
 img_screen (FpDeviceVfs101 *vdev)
 {
-  int y, x, count, top;
+  int y, count, top;
   long int level;
   int last_line = vdev->height - 1;
 
@@ -608,9 +614,8 @@ img_screen (FpDeviceVfs101 *vdev)
 
   /* Scan image and remove noise */
   for (y = vdev->bottom; y <= top; y++)
-    for (x = 6; x < VFS_IMG_WIDTH + 6; x++)
-      if (vdev->buffer[offset (x, y)] > VFS_IMG_MIN_IMAGE_LEVEL)
-        vdev->buffer[offset (x, y)] = 255;
+    fpi_background_clamp_u8 (&vdev->buffer[offset (6, y)], VFS_IMG_WIDTH,
+                             VFS_IMG_MIN_IMAGE_LEVEL);
 };
 
 /* Copy image from reader buffer and put it into image data */
@@ -701,6 +706,55 @@ vfs_finger_state (FpDeviceVfs101 *vdev)
     }
 };
 
+static gchar *
+vfs_calibration_key (FpDeviceVfs101 *self)
+{
+  GUsbDevice *usb_dev = fpi_device_get_usb_device (FP_DEVICE (self));
+
+  return g_strdup_printf ("%04x:%04x:%04x:%s",
+                          g_usb_device_get_vid (usb_dev),
+                          g_usb_device_get_pid (usb_dev),
+                          g_usb_device_get_release (usb_dev),
+                          self->serial ? self->serial : "");
+}
+
+/* Store the contrast found by the contrast scan */
+static void
+vfs_store_calibration (FpDeviceVfs101 *self)
+{
+  g_autofree gchar *key = vfs_calibration_key (self);
+  g_autoptr(GBytes) data = NULL;
+  guint8 contrast = self->contrast;
+
+  data = g_bytes_new (&contrast, sizeof (contrast));
+  fpi_device_set_calibration (FP_DEVICE (self), key, data);
+}
+
+/* Restore the contrast of an earlier contrast scan */
+static gboolean
+vfs_load_calibration (FpDeviceVfs101 *self)
+{
+  g_autofree gchar *key = vfs_calibration_key (self);
+  g_autoptr(GBytes) data = NULL;
+  const guint8 *contrast;
+  gsize len;
+
+  data = fpi_device_get_calibration (FP_DEVICE (self), key, VFS_CALIBRATION_MAX_AGE);
+  if (!data)
+    return FALSE;
+
+  contrast = g_bytes_get_data (data, &len);
+  if (len != 1 || *contrast == 0 || *contrast > 15)
+    {
+      fpi_device_clear_calibration (FP_DEVICE (self));
+      return FALSE;
+    }
+
+  self->contrast = *contrast;
+
+  return TRUE;
+}
+
 /* Check contrast of image */
 static void
 vfs_check_contrast (FpDeviceVfs101 *vdev)
@@ -1172,6 +1226,14 @@ m_init_state (FpiSsm *ssm, FpDevice *_dev)
       break;
 
     case M_INIT_4_SET_EXPOSURE:
+      if (vfs_load_calibration (self))
+        {
+          /* Contrast is known already, skip the scan */
+          fp_dbg ("use cached contrast value = %d", self->contrast);
+          fpi_ssm_jump_to_state (ssm, M_INIT_5_SET_EXPOSURE);
+          break;
+        }
+
       /* Set exposure level of reader */
       vfs_poke (ssm, dev, VFS_REG_IMG_EXPOSURE, 0x4000, 0x02);
       self->counter = 1;
@@ -1202,6 +1264,7 @@ m_init_state (FpiSsm *ssm, FpDevice *_dev)
           self->contrast = self->best_contrast;
           self->counter = 0;
           fp_dbg ("use contrast value = %d", self->contrast);
+          vfs_store_calibration (self);
           fpi_ssm_next_state (ssm);
         }
       else
@@ -1310,6 +1373,20 @@ dev_open (FpImageDevice *dev)
   /* Claim usb interface */
   g_usb_device_claim_interface (fpi_device_get_usb_device (FP_DEVICE (dev)), 0, 0, &error);
 
+  /* Tie a cached calibration to this very sensor where possible */
+  if (!error && g_strcmp0 (g_getenv ("FP_DEVICE_EMULATION"), "1") != 0)
+    {
+      GUsbDevice *usb_dev = fpi_device_get_usb_device (FP_DEVICE (dev));
+      guint8 serial_index = g_usb_device_get_serial_number_index (usb_dev);
+      g_autoptr(GError) serial_error = NULL;
+
+      if (serial_index != 0)
+        self->serial = g_usb_device_get_string_descriptor (usb_dev, serial_index,
+                                                           &serial_error);
+      if (serial_error)
+        fp_dbg ("Could not read serial number: %s", serial_error->message);
+    }
+
   /* Initialize private structure */
   self->seqnum = -1;
   self->buffer = g_malloc0 (VFS_BUFFER_SIZE);
@@ -1330,6 +1407,7 @@ dev_close (FpImageDevice *dev)
                                   0, 0, &error);
 
   g_clear_pointer (&self->buffer, g_free);
+  g_clear_pointer (&self->serial, g_free);
 
   /* Notify close complete */
   fpi_image_device_close_complete (dev, error);
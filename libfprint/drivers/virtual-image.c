@@ -145,6 +145,12 @@ recv_image_hdr_recv_cb (GObject      *source_object,
           fpi_device_remove (FP_DEVICE (self));
           break;
 
+        case -6:
+          /* -6 sets/clears whether near duplicate enroll samples are accepted */
+          fpi_image_device_set_enroll_allow_duplicates (FP_IMAGE_DEVICE (self),
+                                                        !!self->recv_img_hdr[1]);
+          break;
+
         default:
           /* disconnect client, it didn't play fair */
           fpi_device_virtual_listener_connection_close (listener);
@@ -316,6 +322,9 @@ fpi_device_virtual_image_class_init (FpDeviceVirtualImageClass *klass)
   dev_class->type = FP_DEVICE_TYPE_VIRTUAL;
   dev_class->id_table = driver_ids;
 
+  /* Tests feed the same image for all enroll stages */
+  img_class->enroll_allow_duplicates = TRUE;
+
   img_class->img_open = dev_init;
   img_class->img_close = dev_deinit;
 
@@ -23,10 +23,13 @@
 
 #include "fpi-compat.h"
 #include "fpi-assembling.h"
+#include "fpi-background.h"
+#include "fpi-crc.h"
 #include "fpi-device.h"
 #include "fpi-image-device.h"
 #include "fpi-image.h"
 #include "fpi-log.h"
+#include "fpi-metrics.h"
 #include "fpi-print.h"
 #include "fpi-usb-transfer.h"
 #include "fpi-spi-transfer.h"
@@ -22,6 +22,7 @@
 
 #include "fpi-context.h"
 #include "fpi-device.h"
+#include "fpi-metrics.h"
 #include <gusb.h>
 #include <stdio.h>
 
@@ -53,7 +54,7 @@ typedef struct
   gint          pending_devices;
   gboolean      enumerated;
 
-  GArray       *drivers;
+  GPtrArray    *drivers;
   GPtrArray    *devices;
 } FpContextPrivate;
 
@@ -205,6 +206,55 @@ async_device_init_done_cb (GObject *source_object, GAsyncResult *res, gpointer u
   g_signal_emit (context, signals[DEVICE_ADDED_SIGNAL], 0, device);
 }
 
+static void
+match_usb_driver (const FpiDriverInfo *info,
+                  GUsbDevice          *device,
+                  GType               *found_driver,
+                  const FpIdEntry    **found_entry,
+                  gint                *found_score)
+{
+  g_autoptr(FpDeviceClass) cls = g_type_class_ref (info->get_type ());
+  guint16 pid = g_usb_device_get_pid (device);
+  guint16 vid = g_usb_device_get_vid (device);
+  const FpIdEntry *entry;
+
+  for (entry = cls->id_table; entry->pid; entry++)
+    {
+      gint driver_score = 50;
+
+      if (entry->pid != pid || entry->vid != vid)
+        continue;
+
+      if (cls->usb_discover)
+        driver_score = cls->usb_discover (device);
+
+      /* Is this driver better than the one we had? */
+      if (driver_score <= *found_score)
+        continue;
+
+      *found_score = driver_score;
+      *found_driver = G_TYPE_FROM_CLASS (cls);
+      *found_entry = entry;
+    }
+}
+
+static const FpiDriverInfo *
+find_driver (FpContext *self, const char *id)
+{
+  FpContextPrivate *priv = fp_context_get_instance_private (self);
+  guint i;
+
+  for (i = 0; i < priv->drivers->len; i++)
+    {
+      const FpiDriverInfo *info = g_ptr_array_index (priv->drivers, i);
+
+      if (g_str_equal (info->id, id))
+        return info;
+    }
+
+  return NULL;
+}
+
 static void
 usb_device_added_cb (FpContext *self, GUsbDevice *device, GUsbContext *usb_ctx)
 {
@@ -218,33 +268,33 @@ usb_device_added_cb (FpContext *self, GUsbDevice *device, GUsbContext *usb_ctx)
   pid = g_usb_device_get_pid (device);
   vid = g_usb_device_get_vid (device);
 
-  /* Find the best driver to handle this USB device. */
-  for (i = 0; i < priv->drivers->len; i++)
+  /* Find the best driver to handle this USB device. Use the table generated
+   * at build time so that only the classes of candidate drivers are
+   * initialized. */
+  if (fpi_usb_id_table_valid)
     {
-      GType driver = g_array_index (priv->drivers, GType, i);
-      g_autoptr(FpDeviceClass) cls = g_type_class_ref (driver);
-      const FpIdEntry *entry;
+      const FpiUsbIdEntry *usb_id;
 
-      if (cls->type != FP_DEVICE_TYPE_USB)
-        continue;
-
-      for (entry = cls->id_table; entry->pid; entry++)
+      for (usb_id = fpi_usb_id_table; usb_id->driver; usb_id++)
         {
-          gint driver_score = 50;
+          const FpiDriverInfo *info;
 
-          if (entry->pid != pid || entry->vid != vid)
+          if (usb_id->vid != vid || usb_id->pid != pid)
             continue;
 
-          if (cls->usb_discover)
-            driver_score = cls->usb_discover (device);
-
-          /* Is this driver better than the one we had? */
-          if (driver_score <= found_score)
-            continue;
+          info = find_driver (self, usb_id->driver);
+          if (info)
+            match_usb_driver (info, device, &found_driver, &found_entry, &found_score);
+        }
+    }
+  else
+    {
+      for (i = 0; i < priv->drivers->len; i++)
+        {
+          const FpiDriverInfo *info = g_ptr_array_index (priv->drivers, i);
 
-          found_score = driver_score;
-          found_driver = driver;
-          found_entry = entry;
+          if (info->type == FP_DEVICE_TYPE_USB)
+            match_usb_driver (info, device, &found_driver, &found_entry, &found_score);
         }
     }
 
@@ -293,7 +343,7 @@ fp_context_finalize (GObject *object)
 
   g_cancellable_cancel (priv->cancellable);
   g_clear_object (&priv->cancellable);
-  g_clear_pointer (&priv->drivers, g_array_unref);
+  g_clear_pointer (&priv->drivers, g_ptr_array_unref);
   g_clear_pointer (&priv->devices, g_ptr_array_unref);
 
   g_slist_free_full (g_steal_pointer (&priv->sources), (GDestroyNotify) g_source_destroy);
@@ -358,25 +408,19 @@ fp_context_init (FpContext *self)
 {
   g_autoptr(GError) error = NULL;
   FpContextPrivate *priv = fp_context_get_instance_private (self);
+  const FpiDriverInfo *infos;
+  guint n_infos;
   guint i;
 
   g_debug ("Initializing FpContext (libfprint version " LIBFPRINT_VERSION ")");
 
-  priv->drivers = fpi_get_driver_types ();
+  /* Driver classes are only initialized once a device might need them */
+  infos = fpi_get_driver_infos (&n_infos);
+  priv->drivers = g_ptr_array_sized_new (n_infos);
 
-  if (get_drivers_whitelist_env ())
-    {
-      for (i = 0; i < priv->drivers->len;)
-        {
-          GType driver = g_array_index (priv->drivers, GType, i);
-          g_autoptr(FpDeviceClass) cls = g_type_class_ref (driver);
-
-          if (!is_driver_allowed (cls->id))
-            g_array_remove_index (priv->drivers, i);
-          else
-            ++i;
-        }
-    }
+  for (i = 0; i < n_infos; i++)
+    if (is_driver_allowed (infos[i].id))
+      g_ptr_array_add (priv->drivers, (gpointer) & infos[i]);
 
   priv->devices = g_ptr_array_new_with_free_func (g_object_unref);
 
@@ -444,13 +488,17 @@ fp_context_enumerate (FpContext *context)
   /* Handle Virtual devices based on environment variables */
   for (i = 0; i < priv->drivers->len; i++)
     {
-      GType driver = g_array_index (priv->drivers, GType, i);
-      g_autoptr(FpDeviceClass) cls = g_type_class_ref (driver);
+      const FpiDriverInfo *info = g_ptr_array_index (priv->drivers, i);
+      g_autoptr(FpDeviceClass) cls = NULL;
+      GType driver;
       const FpIdEntry *entry;
 
-      if (cls->type != FP_DEVICE_TYPE_VIRTUAL)
+      if (info->type != FP_DEVICE_TYPE_VIRTUAL)
         continue;
 
+      driver = info->get_type ();
+      cls = g_type_class_ref (driver);
+
       for (entry = cls->id_table; entry->pid; entry++)
         {
           const gchar *val;
@@ -489,13 +537,17 @@ fp_context_enumerate (FpContext *context)
     /* for each potential driver, try to match all requested resources. */
     for (i = 0; i < priv->drivers->len; i++)
       {
-        GType driver = g_array_index (priv->drivers, GType, i);
-        g_autoptr(FpDeviceClass) cls = g_type_class_ref (driver);
+        const FpiDriverInfo *info = g_ptr_array_index (priv->drivers, i);
+        g_autoptr(FpDeviceClass) cls = NULL;
+        GType driver;
         const FpIdEntry *entry;
 
-        if (cls->type != FP_DEVICE_TYPE_UDEV)
+        if (info->type != FP_DEVICE_TYPE_UDEV)
           continue;
 
+        driver = info->get_type ();
+        cls = g_type_class_ref (driver);
+
         for (entry = cls->id_table; entry->udev_types; entry++)
           {
             GList *matched_spidev = NULL, *matched_hidraw = NULL;
@@ -600,3 +652,339 @@ fp_context_get_devices (FpContext *context)
 
   return priv->devices;
 }
+
+/**
+ * fp_context_get_metrics:
+ * @context: a #FpContext
+ *
+ * Get usage statistics for all devices of the context, for example the
+ * number of scans and match results, the amount of USB traffic and how
+ * long it took to process images.
+ *
+ * The result is an array of samples of type `a(sa{ss}d)`. Each sample
+ * contains the metric name, a dictionary of labels and the value. All
+ * samples carry a `driver` and a `device` label. The naming follows the
+ * Prometheus conventions, so that the following prints the data in its
+ * text exposition format:
+ *
+ * |[<!-- language="C" -->
+ *   g_autoptr(GVariant) metrics = fp_context_get_metrics (ctx);
+ *   GVariantIter iter;
+ *   GVariantIter *labels;
+ *   const char *name, *key, *value;
+ *   gdouble sample;
+ *
+ *   g_variant_iter_init (&iter, metrics);
+ *   while (g_variant_iter_next (&iter, "(&sa{ss}d)", &name, &labels, &sample))
+ *     {
+ *       g_autoptr(GString) line = g_string_new (name);
+ *       gboolean first = TRUE;
+ *
+ *       while (g_variant_iter_next (labels, "{&s&s}", &key, &value))
+ *         {
+ *           g_string_append_printf (line, "%s%s=\"%s\"", first ? "{" : ",", key, value);
+ *           first = FALSE;
+ *         }
+ *       g_variant_iter_free (labels);
+ *
+ *       g_print ("%s} %g\n", line->str, sample);
+ *     }
+ * ]|
+ *
+ * The values only cover the lifetime of the #FpDevice objects and are not
+ * persisted.
+ *
+ * Returns: (transfer full): a new #GVariant with the samples
+ */
+GVariant *
+fp_context_get_metrics (FpContext *context)
+{
+  FpContextPrivate *priv = fp_context_get_instance_private (context);
+  GVariantBuilder builder;
+  guint i;
+
+  g_return_val_if_fail (FP_IS_CONTEXT (context), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sa{ss}d)"));
+
+  for (i = 0; priv->devices && i < priv->devices->len; i++)
+    fpi_device_metrics_append_samples (g_ptr_array_index (priv->devices, i),
+                                       &builder);
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+typedef struct
+{
+  GCancellable  *cancellable;
+  GCancellable  *parent_cancellable;
+  gulong         parent_cancelled_id;
+  guint          pending;
+  guint          finished;
+
+  FpMatchCb      match_cb;
+  gpointer       match_data;
+  GDestroyNotify match_destroy;
+
+  FpDevice      *device;
+  FpPrint       *match;
+  FpPrint       *print;
+  GError        *error;
+  GError        *device_error;
+} FpContextIdentifyData;
+
+static void
+context_identify_data_free (FpContextIdentifyData *data)
+{
+  if (data->parent_cancellable)
+    g_cancellable_disconnect (data->parent_cancellable, data->parent_cancelled_id);
+  g_clear_object (&data->parent_cancellable);
+  g_clear_object (&data->cancellable);
+
+  if (data->match_destroy)
+    data->match_destroy (data->match_data);
+
+  g_clear_object (&data->device);
+  g_clear_object (&data->match);
+  g_clear_object (&data->print);
+  g_clear_error (&data->error);
+  g_clear_error (&data->device_error);
+  g_free (data);
+}
+
+static void
+context_identify_parent_cancelled (GCancellable          *cancellable,
+                                   FpContextIdentifyData *data)
+{
+  g_cancellable_cancel (data->cancellable);
+}
+
+static void context_identify_maybe_complete (GTask *task);
+
+static void
+context_identify_done_cb (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(FpPrint) match = NULL;
+  g_autoptr(FpPrint) print = NULL;
+  g_autoptr(GError) error = NULL;
+  FpDevice *device = FP_DEVICE (source_object);
+  FpContextIdentifyData *data = g_task_get_task_data (task);
+
+  fp_device_identify_finish (device, res, &match, &print, &error);
+  data->pending--;
+  data->finished++;
+
+  /* The first device that scanned a finger wins, this includes retry errors
+   * as the user needs to be prompted to try again on that device. Other
+   * errors are only reported if no device succeeded. */
+  if (!data->device &&
+      (!error || error->domain == FP_DEVICE_RETRY))
+    {
+      g_debug ("Identification finished on device %s",
+               fp_device_get_name (device));
+
+      data->device = g_object_ref (device);
+      data->match = g_steal_pointer (&match);
+      data->print = g_steal_pointer (&print);
+      data->device_error = g_steal_pointer (&error);
+
+      g_cancellable_cancel (data->cancellable);
+    }
+  else if (error && !data->error &&
+           !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      data->error = g_steal_pointer (&error);
+    }
+
+  context_identify_maybe_complete (task);
+}
+
+static void
+context_identify_maybe_complete (GTask *task)
+{
+  FpContextIdentifyData *data = g_task_get_task_data (task);
+
+  /* Only complete once all devices are idle again */
+  if (data->pending > 0)
+    return;
+
+  if (data->device)
+    {
+      if (data->device_error)
+        g_task_return_error (task, g_steal_pointer (&data->device_error));
+      else
+        g_task_return_boolean (task, TRUE);
+    }
+  else if (g_task_return_error_if_cancelled (task))
+    {
+      return;
+    }
+  else if (data->error)
+    {
+      g_task_return_error (task, g_steal_pointer (&data->error));
+    }
+  else
+    {
+      g_task_return_error (task,
+                           g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                "Operation was cancelled"));
+    }
+}
+
+/**
+ * fp_context_identify:
+ * @context: a #FpContext
+ * @prints: (element-type FpPrint) (transfer none): #GPtrArray of #FpPrint
+ * @cancellable: (nullable): a #GCancellable, or %NULL
+ * @match_cb: (nullable) (scope notified): match reporting callback
+ * @match_data: (closure match_cb): user data for @match_cb
+ * @match_destroy: (destroy match_data): Destroy notify for @match_data
+ * @callback: the function to call on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Start identifying on all open devices that support identification at the
+ * same time. Each device is given the prints of @prints that were created
+ * by its driver, devices without any such print are skipped.
+ *
+ * The operation finishes with the result of the first device that scanned
+ * a finger, identification on all other devices is cancelled. The callback
+ * is only called once all devices are idle again. @match_cb is passed to
+ * every device and may be called for the device that scanned the finger
+ * before that.
+ *
+ * Retrieve the result with fp_context_identify_finish().
+ */
+void
+fp_context_identify (FpContext          *context,
+                     GPtrArray          *prints,
+                     GCancellable       *cancellable,
+                     FpMatchCb           match_cb,
+                     gpointer            match_data,
+                     GDestroyNotify      match_destroy,
+                     GAsyncReadyCallback callback,
+                     gpointer            user_data)
+{
+  FpContextPrivate *priv = fp_context_get_instance_private (context);
+  g_autoptr(GTask) task = NULL;
+  FpContextIdentifyData *data;
+  guint i, j;
+
+  g_return_if_fail (FP_IS_CONTEXT (context));
+
+  task = g_task_new (context, cancellable, callback, user_data);
+
+  data = g_new0 (FpContextIdentifyData, 1);
+  data->cancellable = g_cancellable_new ();
+  data->match_cb = match_cb;
+  data->match_data = match_data;
+  data->match_destroy = match_destroy;
+  g_task_set_task_data (task, data, (GDestroyNotify) context_identify_data_free);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  if (prints == NULL)
+    {
+      g_task_return_error (task,
+                           fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_INVALID,
+                                                     "Invalid gallery array"));
+      return;
+    }
+
+  if (cancellable)
+    {
+      data->parent_cancellable = g_object_ref (cancellable);
+      data->parent_cancelled_id =
+        g_cancellable_connect (cancellable,
+                               G_CALLBACK (context_identify_parent_cancelled),
+                               data, NULL);
+    }
+
+  /* Devices may fail right away, hold a reference until all are started */
+  data->pending = 1;
+
+  for (i = 0; i < priv->devices->len; i++)
+    {
+      FpDevice *device = g_ptr_array_index (priv->devices, i);
+      g_autoptr(GPtrArray) gallery = NULL;
+
+      if (!fp_device_is_open (device) ||
+          !fp_device_has_feature (device, FP_DEVICE_FEATURE_IDENTIFY))
+        continue;
+
+      /* The prints are shared, only the array is per device */
+      gallery = g_ptr_array_sized_new (prints->len);
+      for (j = 0; j < prints->len; j++)
+        {
+          FpPrint *print = g_ptr_array_index (prints, j);
+
+          if (g_strcmp0 (fp_print_get_driver (print), fp_device_get_driver (device)) == 0)
+            g_ptr_array_add (gallery, print);
+        }
+
+      if (gallery->len == 0)
+        continue;
+
+      data->pending++;
+      fp_device_identify (device, gallery, data->cancellable,
+                          match_cb, match_data, NULL,
+                          context_identify_done_cb, g_object_ref (task));
+    }
+
+  data->pending--;
+
+  if (data->pending == 0 && data->finished == 0)
+    {
+      g_task_return_error (task,
+                           fpi_device_error_new_msg (FP_DEVICE_ERROR_NOT_SUPPORTED,
+                                                     "No open device can identify the given prints"));
+      return;
+    }
+
+  context_identify_maybe_complete (task);
+}
+
+/**
+ * fp_context_identify_finish:
+ * @context: A #FpContext
+ * @result: A #GAsyncResult
+ * @device: (out) (transfer full) (nullable): Location for the #FpDevice that scanned the finger, or %NULL
+ * @match: (out) (transfer full) (nullable): Location for the matched #FpPrint, or %NULL
+ * @print: (out) (transfer full) (nullable): Location for the new #FpPrint, or %NULL
+ * @error: Return location for errors, or %NULL to ignore
+ *
+ * Finish an asynchronous operation to identify a print on all devices. This
+ * works like fp_device_identify_finish(), @device is also set if the
+ * device that scanned the finger reported an error of type
+ * %FP_DEVICE_RETRY.
+ *
+ * See fp_context_identify().
+ *
+ * Returns: (type void): %FALSE on error, %TRUE otherwise
+ */
+gboolean
+fp_context_identify_finish (FpContext    *context,
+                            GAsyncResult *result,
+                            FpDevice    **device,
+                            FpPrint     **match,
+                            FpPrint     **print,
+                            GError      **error)
+{
+  FpContextIdentifyData *data;
+
+  g_return_val_if_fail (g_task_is_valid (result, context), FALSE);
+
+  data = g_task_get_task_data (G_TASK (result));
+
+  if (device)
+    *device = data->device ? g_object_ref (data->device) : NULL;
+  if (match)
+    *match = data->match ? g_object_ref (data->match) : NULL;
+  if (print)
+    *print = data->print ? g_object_ref (data->print) : NULL;
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
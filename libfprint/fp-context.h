@@ -49,4 +49,22 @@ void fp_context_enumerate (FpContext *context);
 
 GPtrArray *fp_context_get_devices (FpContext *context);
 
+GVariant *fp_context_get_metrics (FpContext *context);
+
+void fp_context_identify (FpContext          *context,
+                          GPtrArray          *prints,
+                          GCancellable       *cancellable,
+                          FpMatchCb           match_cb,
+                          gpointer            match_data,
+                          GDestroyNotify      match_destroy,
+                          GAsyncReadyCallback callback,
+                          gpointer            user_data);
+
+gboolean fp_context_identify_finish (FpContext    *context,
+                                     GAsyncResult *result,
+                                     FpDevice    **device,
+                                     FpPrint     **match,
+                                     FpPrint     **print,
+                                     GError      **error);
+
 G_END_DECLS
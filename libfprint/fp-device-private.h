@@ -21,6 +21,7 @@
 #pragma once
 
 #include "fpi-device.h"
+#include "fpi-metrics.h"
 
 /* Chosen so that if we turn on after WARM -> COLD, it takes exactly one time
  * constant to go from COLD -> HOT.
@@ -33,6 +34,10 @@
 /* Delay updates by 100ms to avoid hitting the border exactly */
 #define TEMP_DELAY_SECONDS 0.1
 
+/* Leave some headroom when estimating whether the next action fits into
+ * the remaining temperature budget. */
+#define TEMP_THROTTLE_MARGIN 1.25
+
 /* Hopefully 3min is long enough to not get in the way, while also not
  * properly overheating any devices.
  */
@@ -65,6 +70,10 @@ typedef struct
   gint            nr_enroll_stages;
   GSList         *sources;
 
+  /* Coalesced timers, see fpi_device_add_timer() */
+  GSList         *timer_queues;
+  guint           timer_last_id;
+
   /* We always make sure that only one task is run at a time. */
   FpiDeviceAction     current_action;
   GTask              *current_task;
@@ -92,13 +101,30 @@ typedef struct
   GError *suspend_error;
 
   /* Device temperature model information and state */
-  GSource      *temp_timeout;
+  guint         temp_timeout;
   FpTemperature temp_current;
   gint32        temp_hot_seconds;
   gint32        temp_cold_seconds;
   gint64        temp_last_update;
   gboolean      temp_last_active;
   gdouble       temp_current_ratio;
+
+  /* Throttling of actions based on the temperature model */
+  gint64        temp_active_since;
+  gint64        temp_active_estimate;
+  guint         temp_throttle_timeout;
+  gint64        temp_throttle_deadline;
+  gint64        temp_throttle_remaining;
+  void          (*temp_throttle_func) (FpDevice *device);
+
+  /* Cached sensor calibration, see fpi_device_set_calibration() */
+  gchar        *calibration_key;
+  GBytes       *calibration_data;
+  gint64        calibration_time;
+  FpTemperature calibration_temp;
+
+  /* Usage statistics, see fpi_device_metrics_add() */
+  FpiMetrics metrics;
 } FpDevicePrivate;
 
 
@@ -132,5 +158,12 @@ void fpi_device_resume (FpDevice *device);
 
 void fpi_device_configure_wakeup (FpDevice *device,
                                   gboolean  enabled);
+void fpi_device_clear_timers (FpDevice *device);
+
+void fpi_device_run_action (FpDevice *device,
+                            void (*func) (FpDevice *device));
+gint64 fpi_device_get_temp_budget (FpDevice *device);
+gint64 fpi_device_get_temp_throttle (FpDevice *device);
+
 void fpi_device_update_temp (FpDevice *device,
                              gboolean  is_active);
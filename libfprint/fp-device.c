@@ -94,6 +94,20 @@ fp_device_cancel_in_idle_cb (gpointer user_data)
 
   priv->current_idle_cancel_source = NULL;
 
+  /* The driver has not been started yet if the action is being throttled */
+  if (priv->temp_throttle_func)
+    {
+      if (priv->temp_throttle_timeout)
+        fpi_device_remove_timer (self, priv->temp_throttle_timeout);
+      priv->temp_throttle_timeout = 0;
+      priv->temp_throttle_func = NULL;
+
+      fpi_device_action_error (self,
+                               g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                    "Operation was cancelled"));
+      return G_SOURCE_REMOVE;
+    }
+
   if (priv->critical_section)
     priv->cancel_queued = TRUE;
   else
@@ -219,7 +233,8 @@ fp_device_finalize (GObject *object)
   if (priv->is_open)
     g_warning ("User destroyed open device! Not cleaning up properly!");
 
-  g_clear_pointer (&priv->temp_timeout, g_source_destroy);
+  priv->temp_timeout = 0;
+  fpi_device_clear_timers (self);
 
   g_slist_free_full (priv->sources, (GDestroyNotify) g_source_destroy);
 
@@ -230,6 +245,9 @@ fp_device_finalize (GObject *object)
   g_clear_pointer (&priv->device_id, g_free);
   g_clear_pointer (&priv->device_name, g_free);
 
+  g_clear_pointer (&priv->calibration_key, g_free);
+  g_clear_pointer (&priv->calibration_data, g_bytes_unref);
+
   g_clear_object (&priv->usb_device);
   g_clear_pointer (&priv->virtual_env, g_free);
   g_clear_pointer (&priv->udev_data.spidev_path, g_free);
@@ -739,6 +757,137 @@ fp_device_get_temperature (FpDevice *device)
   return priv->temp_current;
 }
 
+/**
+ * fp_device_get_duty_budget:
+ * @device: A #FpDevice
+ *
+ * Retrieves how long the device can be active from now on before it
+ * reaches #FP_TEMPERATURE_HOT. The budget shrinks while an operation is
+ * running and recovers while the device is idle.
+ *
+ * When starting an operation, libfprint delays it if the device would
+ * likely become too hot before it finishes, based on the duration of
+ * earlier operations.
+ *
+ * Returns: The remaining active time in milliseconds, or -1 if the device
+ *   can run continuously.
+ */
+gint
+fp_device_get_duty_budget (FpDevice *device)
+{
+  gint64 budget;
+
+  g_return_val_if_fail (FP_IS_DEVICE (device), -1);
+
+  budget = fpi_device_get_temp_budget (device);
+  if (budget < 0)
+    return -1;
+
+  return MIN (budget / 1000, G_MAXINT);
+}
+
+/**
+ * fp_device_get_calibration_data:
+ * @device: A #FpDevice
+ *
+ * Retrieves the sensor calibration that the driver stored for the device,
+ * so that it can be restored using fp_device_set_calibration_data() after
+ * the process has been restarted. This avoids a slow calibration the first
+ * time the device is used.
+ *
+ * The data is opaque and only valid for the same device and driver, the
+ * driver decides whether it is still recent enough to be used.
+ *
+ * Returns: (transfer full) (nullable): A #GVariant with the calibration, or
+ *   %NULL if the driver did not store any.
+ */
+GVariant *
+fp_device_get_calibration_data (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  g_return_val_if_fail (FP_IS_DEVICE (device), NULL);
+
+  if (!priv->calibration_data)
+    return NULL;
+
+  return g_variant_ref_sink (g_variant_new ("(sssxu@ay)",
+                                            fp_device_get_driver (device),
+                                            priv->device_id ? priv->device_id : "",
+                                            priv->calibration_key,
+                                            priv->calibration_time,
+                                            priv->calibration_temp,
+                                            g_variant_new_from_bytes (G_VARIANT_TYPE_BYTESTRING,
+                                                                      priv->calibration_data,
+                                                                      TRUE)));
+}
+
+/**
+ * fp_device_set_calibration_data:
+ * @device: A #FpDevice
+ * @data: A #GVariant previously returned by fp_device_get_calibration_data()
+ * @error: Return location for errors, or %NULL to ignore
+ *
+ * Restores a sensor calibration that was saved earlier, see
+ * fp_device_get_calibration_data(). This should be done before opening
+ * the device.
+ *
+ * Returns: %TRUE if the data was accepted, %FALSE if it belongs to a
+ *   different device or is malformed.
+ */
+gboolean
+fp_device_set_calibration_data (FpDevice *device,
+                                GVariant *data,
+                                GError  **error)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  g_autoptr(GVariant) blob = NULL;
+  const char *driver;
+  const char *device_id;
+  const char *key;
+  gint64 time;
+  guint32 temp;
+
+  g_return_val_if_fail (FP_IS_DEVICE (device), FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  if (!g_variant_is_of_type (data, G_VARIANT_TYPE ("(sssxuay)")))
+    {
+      g_propagate_error (error,
+                         fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_INVALID,
+                                                   "Calibration data has the wrong type"));
+      return FALSE;
+    }
+
+  g_variant_get (data, "(&s&s&sxu@ay)", &driver, &device_id, &key, &time, &temp, &blob);
+
+  if (g_strcmp0 (driver, fp_device_get_driver (device)) != 0 ||
+      g_strcmp0 (device_id, priv->device_id ? priv->device_id : "") != 0)
+    {
+      g_propagate_error (error,
+                         fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_INVALID,
+                                                   "Calibration data is for a different device"));
+      return FALSE;
+    }
+
+  if (temp > FP_TEMPERATURE_HOT)
+    {
+      g_propagate_error (error,
+                         fpi_device_error_new_msg (FP_DEVICE_ERROR_DATA_INVALID,
+                                                   "Calibration data is corrupt"));
+      return FALSE;
+    }
+
+  g_free (priv->calibration_key);
+  priv->calibration_key = g_strdup (key);
+  g_clear_pointer (&priv->calibration_data, g_bytes_unref);
+  priv->calibration_data = g_variant_get_data_as_bytes (blob);
+  priv->calibration_time = time;
+  priv->calibration_temp = temp;
+
+  return TRUE;
+}
+
 /**
  * fp_device_supports_identify:
  * @device: A #FpDevice
@@ -1202,7 +1351,7 @@ fp_device_enroll (FpDevice           *device,
   // Attach the progress data as task data so that it is destroyed
   g_task_set_task_data (priv->current_task, data, (GDestroyNotify) enroll_data_free);
 
-  FP_DEVICE_GET_CLASS (device)->enroll (device);
+  fpi_device_run_action (device, FP_DEVICE_GET_CLASS (device)->enroll);
 }
 
 /**
@@ -1320,7 +1469,7 @@ fp_device_verify (FpDevice           *device,
   // Attach the match data as task data so that it is destroyed
   g_task_set_task_data (priv->current_task, data, (GDestroyNotify) match_data_free);
 
-  cls->verify (device);
+  fpi_device_run_action (device, cls->verify);
 }
 
 /**
@@ -1461,7 +1610,7 @@ fp_device_identify (FpDevice           *device,
   // Attach the match data as task data so that it is destroyed
   g_task_set_task_data (priv->current_task, data, (GDestroyNotify) match_data_free);
 
-  cls->identify (device);
+  fpi_device_run_action (device, cls->identify);
 }
 
 /**
@@ -1573,7 +1722,7 @@ fp_device_capture (FpDevice           *device,
 
   priv->wait_for_finger = wait_for_finger;
 
-  cls->capture (device);
+  fpi_device_run_action (device, cls->capture);
 }
 
 /**
@@ -225,6 +225,11 @@ FpScanType   fp_device_get_scan_type (FpDevice *device);
 FpFingerStatusFlags fp_device_get_finger_status (FpDevice *device);
 gint         fp_device_get_nr_enroll_stages (FpDevice *device);
 FpTemperature fp_device_get_temperature (FpDevice *device);
+gint          fp_device_get_duty_budget (FpDevice *device);
+GVariant *   fp_device_get_calibration_data (FpDevice *device);
+gboolean     fp_device_set_calibration_data (FpDevice *device,
+                                             GVariant *data,
+                                             GError  **error);
 
 FpDeviceFeature     fp_device_get_features (FpDevice *device);
 gboolean            fp_device_has_feature (FpDevice       *device,
@@ -20,26 +20,57 @@
 #pragma once
 
 #include "fpi-image-device.h"
+#include "fpi-image.h"
 
 #define IMG_ENROLL_STAGES 5
+#define BOZORTH3_DEFAULT_THRESHOLD 40
+/* Enroll samples scoring this many times the threshold are near duplicates */
+#define IMG_ENROLL_DUPLICATE_FACTOR 4
+/* Accept a near duplicate enroll sample after rejecting this many in a row */
+#define IMG_ENROLL_MAX_REJECTS 3
+
+/* Matches scoring this many times the threshold update the template */
+#define IMG_ADAPTIVE_UPDATE_FACTOR 2
+/* Templates do not grow beyond this many samples when updating them */
+#define IMG_ADAPTIVE_MAX_SAMPLES (IMG_ENROLL_STAGES * 2)
+
+/* Weight of earlier matches is halved after this many identifications */
+#define IMG_MATCH_HISTORY_HALF_LIFE 32
+/* At most this many prints are remembered, the least used ones are dropped */
+#define IMG_MATCH_HISTORY_SIZE 256
 
 typedef struct
 {
-  FpiImageDeviceState state;
-  gboolean            active;
+  FpiImageDeviceState  state;
+  gboolean             active;
+
+  gboolean             finger_present;
 
-  gboolean            finger_present;
+  gint                 enroll_stage;
+  gint                 enroll_rejects;
+  gboolean             enroll_allow_duplicates;
 
-  gint                enroll_stage;
+  gboolean             minutiae_scan_active;
+  gint64               minutiae_scan_start;
+  guint                extraction_time_budget;
+  FpiMindtctWorkspace *mindtct_workspace;
+  GError              *action_error;
+  FpImage             *capture_image;
 
-  gboolean            minutiae_scan_active;
-  GError             *action_error;
-  FpImage            *capture_image;
+  /* Threshold used for matching, either the one of the driver or the one
+   * for target_far */
+  gint                 bz3_threshold;
+  gint                 driver_bz3_threshold;
+  gdouble              target_far;
+  gboolean             adaptive_update;
 
-  gint                bz3_threshold;
+  /* Recently matched prints, to try them first during identification */
+  GHashTable          *match_history;
+  guint                match_generation;
 } FpImageDevicePrivate;
 
 
 void fpi_image_device_activate (FpImageDevice *image_device);
+void fpi_image_device_update_threshold (FpImageDevice *image_device);
 void fpi_image_device_deactivate (FpImageDevice *image_device,
                                   gboolean       cancelling);
@@ -22,8 +22,6 @@
 
 #include "fp-image-device-private.h"
 
-#define BOZORTH3_DEFAULT_THRESHOLD 40
-
 /**
  * SECTION: fp-image-device
  * @title: FpImageDevice
@@ -36,6 +34,9 @@ G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (FpImageDevice, fp_image_device, FP_TYPE_DEV
 
 enum {
   PROP_0,
+  PROP_ADAPTIVE_UPDATE,
+  PROP_TARGET_FAR,
+  PROP_EXTRACTION_TIME_BUDGET,
   PROP_FPI_STATE,
   N_PROPS
 };
@@ -75,6 +76,7 @@ fp_image_device_close (FpDevice *device)
   FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
 
   g_assert (priv->active == FALSE);
+  g_clear_pointer (&priv->mindtct_workspace, fpi_mindtct_workspace_unref);
   cls->img_close (self);
 }
 
@@ -131,6 +133,7 @@ fp_image_device_start_capture_action (FpDevice *device)
     }
 
   priv->enroll_stage = 0;
+  priv->enroll_rejects = 0;
   /* The internal state machine guarantees both of these. */
   g_assert (!priv->finger_present);
   g_assert (!priv->minutiae_scan_active);
@@ -150,6 +153,8 @@ fp_image_device_finalize (GObject *object)
   FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
 
   g_assert (priv->active == FALSE);
+  g_clear_pointer (&priv->mindtct_workspace, fpi_mindtct_workspace_unref);
+  g_clear_pointer (&priv->match_history, g_hash_table_unref);
 
   G_OBJECT_CLASS (fp_image_device_parent_class)->finalize (object);
 }
@@ -177,6 +182,18 @@ fp_image_device_get_property (GObject    *object,
 
   switch (prop_id)
     {
+    case PROP_ADAPTIVE_UPDATE:
+      g_value_set_boolean (value, priv->adaptive_update);
+      break;
+
+    case PROP_TARGET_FAR:
+      g_value_set_double (value, priv->target_far);
+      break;
+
+    case PROP_EXTRACTION_TIME_BUDGET:
+      g_value_set_uint (value, priv->extraction_time_budget);
+      break;
+
     case PROP_FPI_STATE:
       g_value_set_enum (value, priv->state);
       break;
@@ -186,6 +203,35 @@ fp_image_device_get_property (GObject    *object,
     }
 }
 
+static void
+fp_image_device_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+  FpImageDevice *self = FP_IMAGE_DEVICE (object);
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+
+  switch (prop_id)
+    {
+    case PROP_ADAPTIVE_UPDATE:
+      priv->adaptive_update = g_value_get_boolean (value);
+      break;
+
+    case PROP_TARGET_FAR:
+      priv->target_far = g_value_get_double (value);
+      fpi_image_device_update_threshold (self);
+      break;
+
+    case PROP_EXTRACTION_TIME_BUDGET:
+      priv->extraction_time_budget = g_value_get_uint (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
 static void
 fp_image_device_constructed (GObject *obj)
 {
@@ -194,9 +240,12 @@ fp_image_device_constructed (GObject *obj)
   FpImageDeviceClass *cls = FP_IMAGE_DEVICE_GET_CLASS (self);
 
   /* Set default threshold. */
-  priv->bz3_threshold = BOZORTH3_DEFAULT_THRESHOLD;
+  priv->driver_bz3_threshold = BOZORTH3_DEFAULT_THRESHOLD;
   if (cls->bz3_threshold > 0)
-    priv->bz3_threshold = cls->bz3_threshold;
+    priv->driver_bz3_threshold = cls->bz3_threshold;
+  fpi_image_device_update_threshold (self);
+
+  priv->enroll_allow_duplicates = cls->enroll_allow_duplicates;
 
   G_OBJECT_CLASS (fp_image_device_parent_class)->constructed (obj);
 }
@@ -209,6 +258,7 @@ fp_image_device_class_init (FpImageDeviceClass *klass)
 
   object_class->finalize = fp_image_device_finalize;
   object_class->get_property = fp_image_device_get_property;
+  object_class->set_property = fp_image_device_set_property;
   object_class->constructed = fp_image_device_constructed;
 
   /* Set default enroll stage count. */
@@ -230,6 +280,63 @@ fp_image_device_class_init (FpImageDeviceClass *klass)
   klass->activate = fp_image_device_default_activate;
   klass->deactivate = fp_image_device_default_deactivate;
 
+  /**
+   * FpImageDevice:adaptive-update:
+   *
+   * Whether to update prints using confidently matching scans. When
+   * enabled, a verify or identify operation that matches with a high score
+   * adds the new scan to the matched print, replacing the most redundant
+   * sample once the print holds a certain number of them. This counters
+   * ageing of the enrolled print, e.g. due to skin changes.
+   *
+   * The matched print is modified in place, i.e. the template passed to
+   * fp_device_verify() or the match returned by fp_device_identify_finish().
+   * API users should store it again after a successful match.
+   */
+  properties[PROP_ADAPTIVE_UPDATE] =
+    g_param_spec_boolean ("adaptive-update",
+                          "Adaptive update",
+                          "Whether to update prints using confidently matching scans",
+                          FALSE,
+                          G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE);
+
+  /**
+   * FpImageDevice::fpi-target-far: (skip)
+   *
+   * This property is only for internal purposes.
+   *
+   * The false accept rate to pick the match threshold for, using the
+   * #FpiScoreCalibration of the driver. No driver ships a measured table
+   * yet and the generic estimate is not a real false accept rate, so this
+   * is not public API. Set to 0 to use the threshold of the driver.
+   *
+   * Stability: private
+   */
+  properties[PROP_TARGET_FAR] =
+    g_param_spec_double ("fpi-target-far",
+                         "Target FAR",
+                         "Private: The false accept rate to pick the match threshold for",
+                         0.0, 1.0, 0.0,
+                         G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE);
+
+  /**
+   * FpImageDevice:extraction-time-budget:
+   *
+   * The maximum time in milliseconds that the minutiae extraction may
+   * take for a single image. Unusual images, e.g. with a lot of noise,
+   * can take very long to process. If the budget is exceeded, the scan
+   * is rejected with %FP_DEVICE_RETRY_GENERAL instead, so that the user
+   * gets feedback quickly.
+   *
+   * Set to 0 to not limit the extraction time, which is the default.
+   */
+  properties[PROP_EXTRACTION_TIME_BUDGET] =
+    g_param_spec_uint ("extraction-time-budget",
+                       "Extraction time budget",
+                       "Maximum time in milliseconds for the minutiae extraction of an image",
+                       0, G_MAXUINT, 0,
+                       G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE);
+
   /**
    * FpImageDevice::fpi-image-device-state: (skip)
    *
@@ -158,23 +158,42 @@ fp_image_init (FpImage *self)
 {
 }
 
+struct _FpiMindtctWorkspace
+{
+  gint               ref_count;
+  gint               in_use;
+  MINDTCT_WORKSPACE *lfs;
+};
+
 typedef struct
 {
-  GAsyncReadyCallback user_cb;
-  struct fp_minutiae *minutiae;
+  GAsyncReadyCallback  user_cb;
+  FpiMindtctWorkspace *workspace;
+  struct fp_minutiae  *minutiae;
   gint                width, height;
   gdouble             ppmm;
   FpiImageFlags       flags;
   guchar             *image;
   guchar             *binarized;
+  FpiMinutiaeProfile  profile;
+  guint               time_budget_ms;
 } DetectMinutiaeData;
 
+typedef struct
+{
+  GCancellable *cancellable;
+  gint64        deadline;
+  gint64        emulated_time;
+  gboolean      emulated_clock;
+} DetectMinutiaeAbort;
+
 static void
 fp_image_detect_minutiae_free (DetectMinutiaeData *data)
 {
   g_clear_pointer (&data->image, g_free);
   g_clear_pointer (&data->minutiae, free_minutiae);
   g_clear_pointer (&data->binarized, g_free);
+  g_clear_pointer (&data->workspace, fpi_mindtct_workspace_unref);
   g_free (data);
 }
 
@@ -265,6 +284,33 @@ invert_colors (guint8 *data, gint width, gint height)
     data[i] = 0xff - data[i];
 }
 
+/* When emulating, every poll advances the clock by one millisecond so that
+ * the time budget depends on the work done rather than on the machine. */
+static gint64
+fp_image_detect_minutiae_get_time (DetectMinutiaeAbort *abort_info)
+{
+  if (!abort_info->emulated_clock)
+    return g_get_monotonic_time ();
+
+  abort_info->emulated_time += G_TIME_SPAN_MILLISECOND;
+  return abort_info->emulated_time;
+}
+
+/* Polled by mindtct between its processing steps */
+static int
+fp_image_detect_minutiae_should_abort (void *user_data)
+{
+  DetectMinutiaeAbort *abort_info = user_data;
+
+  if (g_cancellable_is_cancelled (abort_info->cancellable))
+    return TRUE;
+
+  if (abort_info->deadline <= 0)
+    return FALSE;
+
+  return fp_image_detect_minutiae_get_time (abort_info) >= abort_info->deadline;
+}
+
 static void
 fp_image_detect_minutiae_thread_func (GTask        *task,
                                       gpointer      source_object,
@@ -272,18 +318,33 @@ fp_image_detect_minutiae_thread_func (GTask        *task,
                                       GCancellable *cancellable)
 {
   g_autoptr(GTimer) timer = NULL;
+  g_autoptr(FpiMindtctWorkspace) workspace = NULL;
   DetectMinutiaeData *data = task_data;
   struct fp_minutiae *minutiae = NULL;
-  g_autofree gint *direction_map = NULL;
-  g_autofree gint *low_contrast_map = NULL;
-  g_autofree gint *low_flow_map = NULL;
-  g_autofree gint *high_curve_map = NULL;
-  g_autofree gint *quality_map = NULL;
+  gint *direction_map = NULL;
+  gint *low_contrast_map = NULL;
+  gint *low_flow_map = NULL;
+  gint *high_curve_map = NULL;
+  gint *quality_map = NULL;
   g_autofree guchar *bdata = NULL;
   gint map_w, map_h;
   gint bw, bh, bd;
   gint r;
-  g_autofree LFSPARMS *lfsparms = NULL;
+  LFSPARMS lfsparms;
+  DetectMinutiaeAbort abort_info = { cancellable, 0, 0, FALSE };
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  if (g_strcmp0 (g_getenv ("FP_DEVICE_EMULATION"), "1") == 0)
+    abort_info.emulated_clock = TRUE;
+
+  if (data->time_budget_ms > 0)
+    abort_info.deadline = fp_image_detect_minutiae_get_time (&abort_info) +
+                          data->time_budget_ms * G_TIME_SPAN_MILLISECOND;
 
   /* Normalize the image first */
   if (data->flags & FPI_IMAGE_H_FLIPPED)
@@ -297,21 +358,45 @@ fp_image_detect_minutiae_thread_func (GTask        *task,
 
   data->flags &= ~(FPI_IMAGE_H_FLIPPED | FPI_IMAGE_V_FLIPPED | FPI_IMAGE_COLORS_INVERTED);
 
-  lfsparms = g_memdup2 (&g_lfsparms_V2, sizeof (LFSPARMS));
-  lfsparms->remove_perimeter_pts = data->flags & FPI_IMAGE_PARTIAL ? TRUE : FALSE;
+  fpi_minutiae_profile_to_lfsparms (&data->profile, &lfsparms);
+  lfsparms.remove_perimeter_pts = data->flags & FPI_IMAGE_PARTIAL ? TRUE : FALSE;
+
+  /* Use the shared workspace unless another detection is using it,
+   * the maps it returns are owned by the workspace. */
+  if (data->workspace && g_atomic_int_compare_and_exchange (&data->workspace->in_use, FALSE, TRUE))
+    workspace = fpi_mindtct_workspace_ref (data->workspace);
+  else
+    workspace = fpi_mindtct_workspace_new ();
+
+  workspace->lfs->abort_func = fp_image_detect_minutiae_should_abort;
+  workspace->lfs->abort_data = &abort_info;
 
   timer = g_timer_new ();
   r = get_minutiae (&minutiae, &quality_map, &direction_map,
                     &low_contrast_map, &low_flow_map, &high_curve_map,
                     &map_w, &map_h, &bdata, &bw, &bh, &bd,
                     data->image, data->width, data->height, 8,
-                    data->ppmm, lfsparms);
+                    data->ppmm, &lfsparms, workspace->lfs);
   g_timer_stop (timer);
+
+  workspace->lfs->abort_func = NULL;
+  workspace->lfs->abort_data = NULL;
+  g_atomic_int_set (&workspace->in_use, FALSE);
   fp_dbg ("Minutiae scan completed in %f secs", g_timer_elapsed (timer, NULL));
 
   data->binarized = g_steal_pointer (&bdata);
   data->minutiae = minutiae;
 
+  if (r == LFS_ABORTED)
+    {
+      if (!g_task_return_error_if_cancelled (task))
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                                 "Minutiae scan exceeded its time budget of %u ms",
+                                 data->time_budget_ms);
+      g_object_unref (task);
+      return;
+    }
+
   if (r)
     {
       fp_err ("get minutiae failed, code %d", r);
@@ -437,13 +522,48 @@ fp_image_get_minutiae (FpImage *self)
  * @callback: the function to call on completion
  * @user_data: the data to pass to @callback
  *
- * Detects the minutiae found in an image.
+ * Detects the minutiae found in an image. Cancelling @cancellable stops
+ * the detection at the next processing step.
  */
 void
 fp_image_detect_minutiae (FpImage            *self,
                           GCancellable       *cancellable,
                           GAsyncReadyCallback callback,
                           gpointer            user_data)
+{
+  fpi_image_detect_minutiae_with_workspace (self, NULL, NULL, cancellable, 0,
+                                            callback, user_data);
+}
+
+/**
+ * fpi_image_detect_minutiae_with_workspace:
+ * @self: A #FpImage
+ * @workspace: (nullable): A #FpiMindtctWorkspace to reuse, or %NULL
+ * @profile: (nullable): A #FpiMinutiaeProfile to use, or %NULL for the
+ *   defaults
+ * @cancellable: a #GCancellable, or %NULL
+ * @time_budget_ms: Maximum time the detection may take, or 0 for no limit
+ * @callback: the function to call on completion
+ * @user_data: the data to pass to @callback
+ *
+ * Detects the minutiae found in an image like fp_image_detect_minutiae(),
+ * but reuses the buffers held by @workspace. If @workspace is busy with
+ * another detection, a temporary one is used instead.
+ *
+ * If the detection takes longer than @time_budget_ms, it fails with
+ * %G_IO_ERROR_TIMED_OUT. With FP_DEVICE_EMULATION set, each processing
+ * step counts as one millisecond, so that the outcome is reproducible.
+ *
+ * Finish the operation using fp_image_detect_minutiae_finish().
+ */
+void
+fpi_image_detect_minutiae_with_workspace (FpImage                  *self,
+                                          FpiMindtctWorkspace      *workspace,
+                                          const FpiMinutiaeProfile *profile,
+                                          GCancellable             *cancellable,
+                                          guint                     time_budget_ms,
+                                          GAsyncReadyCallback       callback,
+                                          gpointer                  user_data)
 {
   GTask *task;
   DetectMinutiaeData *data = g_new0 (DetectMinutiaeData, 1);
@@ -456,12 +576,75 @@ fp_image_detect_minutiae (FpImage            *self,
   data->width = self->width;
   data->height = self->height;
   data->ppmm = self->ppmm;
+  if (profile)
+    data->profile = *profile;
+  data->time_budget_ms = time_budget_ms;
   data->user_cb = callback;
+  if (workspace)
+    data->workspace = fpi_mindtct_workspace_ref (workspace);
 
   g_task_set_task_data (task, data, (GDestroyNotify) fp_image_detect_minutiae_free);
   g_task_run_in_thread (task, fp_image_detect_minutiae_thread_func);
 }
 
+/**
+ * fpi_mindtct_workspace_new:
+ *
+ * Creates an empty workspace for minutiae detection, see
+ * fpi_image_detect_minutiae_with_workspace().
+ *
+ * Returns: (transfer full): A newly created #FpiMindtctWorkspace
+ */
+FpiMindtctWorkspace *
+fpi_mindtct_workspace_new (void)
+{
+  FpiMindtctWorkspace *workspace = g_new0 (FpiMindtctWorkspace, 1);
+
+  workspace->ref_count = 1;
+  alloc_workspace (&workspace->lfs);
+
+  return workspace;
+}
+
+/**
+ * fpi_mindtct_workspace_ref:
+ * @workspace: A #FpiMindtctWorkspace
+ *
+ * Increments the reference count of @workspace by one.
+ *
+ * Returns: (transfer full): @workspace
+ */
+FpiMindtctWorkspace *
+fpi_mindtct_workspace_ref (FpiMindtctWorkspace *workspace)
+{
+  g_return_val_if_fail (workspace, NULL);
+  g_return_val_if_fail (workspace->ref_count, NULL);
+
+  g_atomic_int_inc (&workspace->ref_count);
+
+  return workspace;
+}
+
+/**
+ * fpi_mindtct_workspace_unref:
+ * @workspace: A #FpiMindtctWorkspace
+ *
+ * Decrements the reference count of @workspace by one, freeing the
+ * structure and all of its buffers when the count drops to zero.
+ */
+void
+fpi_mindtct_workspace_unref (FpiMindtctWorkspace *workspace)
+{
+  g_return_if_fail (workspace);
+  g_return_if_fail (workspace->ref_count);
+
+  if (!g_atomic_int_dec_and_test (&workspace->ref_count))
+    return;
+
+  free_workspace (workspace->lfs);
+  g_free (workspace);
+}
+
 /**
  * fp_image_detect_minutiae_finish:
  * @self: A #FpImage
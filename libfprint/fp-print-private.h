@@ -43,4 +43,16 @@ struct _FpPrint
 
   GVariant  *data;
   GPtrArray *prints;
+
+  /* Quality of an enroll sample, see fp_print_get_enroll_quality() */
+  gboolean has_enroll_quality;
+  gdouble  enroll_consistency;
+  gdouble  enroll_coverage;
+
+  /* Usage statistics, see fp_print_get_match_count() */
+  GDateTime *last_match;
+  guint      match_count;
+  guint      no_match_count;
+  guint      score_count;
+  gdouble    score_mean;
 };
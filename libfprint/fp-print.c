@@ -78,6 +78,7 @@ fp_print_finalize (GObject *object)
   g_clear_pointer (&self->username, g_free);
   g_clear_pointer (&self->description, g_free);
   g_clear_pointer (&self->enroll_date, g_date_free);
+  g_clear_pointer (&self->last_match, g_date_time_unref);
   g_clear_pointer (&self->data, g_variant_unref);
   g_clear_pointer (&self->prints, g_ptr_array_unref);
 
@@ -401,6 +402,130 @@ fp_print_get_device_stored (FpPrint *print)
   return print->device_stored;
 }
 
+/**
+ * fp_print_get_enroll_quality:
+ * @print: A #FpPrint
+ * @consistency: (out) (optional): Return location for the consistency
+ * @coverage: (out) (optional): Return location for the coverage
+ *
+ * Retrieves how well a scan that was passed to the #FpEnrollProgress
+ * callback fits the earlier scans of the same enrollment. This is only
+ * available if the device evaluates the enroll samples itself, which is
+ * the case for image based devices.
+ *
+ * @consistency is the fraction of the earlier scans that the new scan
+ * matches, a low value indicates that a different finger may have been
+ * used. @coverage approaches 1.0 the less the scan overlaps with the
+ * best matching earlier scan, so that it is likely to add a new area of
+ * the finger to the enrolled print.
+ *
+ * Returns: %TRUE if the values are available
+ */
+gboolean
+fp_print_get_enroll_quality (FpPrint *print,
+                             gdouble *consistency,
+                             gdouble *coverage)
+{
+  g_return_val_if_fail (FP_IS_PRINT (print), FALSE);
+
+  if (!print->has_enroll_quality)
+    return FALSE;
+
+  if (consistency)
+    *consistency = print->enroll_consistency;
+  if (coverage)
+    *coverage = print->enroll_coverage;
+
+  return TRUE;
+}
+
+/**
+ * fp_print_get_last_match:
+ * @print: A #FpPrint
+ *
+ * Returns the time at which @print was last matched by a verify or
+ * identify operation. Like the other usage statistics, this is kept when
+ * the print is serialized.
+ *
+ * Returns: (transfer none) (nullable): The time of the last match, or
+ *   %NULL if @print has not been matched yet
+ */
+GDateTime *
+fp_print_get_last_match (FpPrint *print)
+{
+  g_return_val_if_fail (FP_IS_PRINT (print), NULL);
+
+  return print->last_match;
+}
+
+/**
+ * fp_print_get_match_count:
+ * @print: A #FpPrint
+ *
+ * Returns how often @print was matched by a verify or identify operation.
+ * Together with fp_print_get_no_match_count() and
+ * fp_print_get_score_mean() this allows detecting prints that do not
+ * work well anymore and should be enrolled again.
+ *
+ * Returns: The number of matches
+ */
+guint
+fp_print_get_match_count (FpPrint *print)
+{
+  g_return_val_if_fail (FP_IS_PRINT (print), 0);
+
+  return print->match_count;
+}
+
+/**
+ * fp_print_get_no_match_count:
+ * @print: A #FpPrint
+ *
+ * Returns how often a scan was verified against @print without matching.
+ * Identify operations do not count here, as the scan may simply belong to
+ * a different print of the gallery.
+ *
+ * Returns: The number of failed verify attempts
+ */
+guint
+fp_print_get_no_match_count (FpPrint *print)
+{
+  g_return_val_if_fail (FP_IS_PRINT (print), 0);
+
+  return print->no_match_count;
+}
+
+/**
+ * fp_print_get_score_mean:
+ * @print: A #FpPrint
+ * @mean: (out) (optional): Return location for the mean score
+ *
+ * Retrieves the rolling mean of the scores with which @print was matched.
+ * Recent matches are weighted more strongly, so that a decreasing value
+ * indicates that the print matches worse over time. The scale of the
+ * score depends on the driver, only values from the same device should
+ * be compared.
+ *
+ * The value is only available if the driver reports match scores, which
+ * is the case for image based devices.
+ *
+ * Returns: %TRUE if the value is available
+ */
+gboolean
+fp_print_get_score_mean (FpPrint *print,
+                         gdouble *mean)
+{
+  g_return_val_if_fail (FP_IS_PRINT (print), FALSE);
+
+  if (print->score_count == 0)
+    return FALSE;
+
+  if (mean)
+    *mean = print->score_mean;
+
+  return TRUE;
+}
+
 /**
  * fp_print_get_image:
  * @print: A #FpPrint
@@ -676,8 +801,24 @@ fp_print_serialize (FpPrint *print,
   else
     g_variant_builder_add (&builder, "i", G_MININT32);
 
-  /* Unused a{sv} for expansion */
+  /* a{sv} for expansion, older versions ignore any entries in it */
   g_variant_builder_open (&builder, G_VARIANT_TYPE_VARDICT);
+  if (print->last_match)
+    g_variant_builder_add (&builder, "{sv}", "last-match",
+                           g_variant_new_int64 (g_date_time_to_unix (print->last_match)));
+  if (print->match_count > 0)
+    g_variant_builder_add (&builder, "{sv}", "match-count",
+                           g_variant_new_uint32 (print->match_count));
+  if (print->no_match_count > 0)
+    g_variant_builder_add (&builder, "{sv}", "no-match-count",
+                           g_variant_new_uint32 (print->no_match_count));
+  if (print->score_count > 0)
+    {
+      g_variant_builder_add (&builder, "{sv}", "score-count",
+                             g_variant_new_uint32 (print->score_count));
+      g_variant_builder_add (&builder, "{sv}", "score-mean",
+                             g_variant_new_double (print->score_mean));
+    }
   g_variant_builder_close (&builder);
 
   /* Insert NBIS print data for type NBIS, otherwise the GVariant directly */
@@ -765,6 +906,7 @@ fp_print_deserialize (const guchar *data,
   g_autoptr(GVariant) raw_value = NULL;
   g_autoptr(GVariant) value = NULL;
   g_autoptr(GVariant) print_data = NULL;
+  g_autoptr(GVariant) extra = NULL;
   g_autoptr(GDate) date = NULL;
   guchar *aligned_data = NULL;
   guint8 finger_int8;
@@ -776,6 +918,7 @@ fp_print_deserialize (const guchar *data,
   const gchar *driver;
   const gchar *device_id;
   gboolean device_stored;
+  gint64 last_match;
 
   g_assert (data);
   g_assert (length > 3);
@@ -815,7 +958,7 @@ fp_print_deserialize (const guchar *data,
                  &username,
                  &description,
                  &julian_date,
-                 NULL,
+                 &extra,
                  &print_data);
 
   finger = finger_int8;
@@ -897,6 +1040,15 @@ fp_print_deserialize (const guchar *data,
                 "enroll_date", date,
                 NULL);
 
+  /* Usage statistics, missing in prints from older versions */
+  if (g_variant_lookup (extra, "last-match", "x", &last_match))
+    result->last_match = g_date_time_new_from_unix_utc (last_match);
+  g_variant_lookup (extra, "match-count", "u", &result->match_count);
+  g_variant_lookup (extra, "no-match-count", "u", &result->no_match_count);
+  if (g_variant_lookup (extra, "score-count", "u", &result->score_count) &&
+      !g_variant_lookup (extra, "score-mean", "d", &result->score_mean))
+    result->score_count = 0;
+
   return g_steal_pointer (&result);
 
 invalid_format:
@@ -89,6 +89,14 @@ const gchar *fp_print_get_username (FpPrint *print);
 const gchar *fp_print_get_description (FpPrint *print);
 const GDate *fp_print_get_enroll_date (FpPrint *print);
 gboolean     fp_print_get_device_stored (FpPrint *print);
+gboolean     fp_print_get_enroll_quality (FpPrint *print,
+                                          gdouble *consistency,
+                                          gdouble *coverage);
+GDateTime   *fp_print_get_last_match (FpPrint *print);
+guint        fp_print_get_match_count (FpPrint *print);
+guint        fp_print_get_no_match_count (FpPrint *print);
+gboolean     fp_print_get_score_mean (FpPrint *print,
+                                      gdouble *mean);
 
 void         fp_print_set_finger (FpPrint *print,
                                   FpFinger finger);
@@ -129,54 +129,90 @@ find_overlap (struct fpi_frame_asmbl_ctx *ctx,
     }
 }
 
-static unsigned int
-do_movement_estimation (struct fpi_frame_asmbl_ctx *ctx,
-                        GSList *stripes, gboolean reverse)
+/**
+ * fpi_estimate_frame_movement:
+ * @ctx: #fpi_frame_asmbl_ctx - frame assembling context
+ * @prev_frame: the #fpi_frame captured before @frame
+ * @frame: the newly captured #fpi_frame
+ *
+ * Estimates the movement between two adjacent frames for both possible
+ * swipe directions and stores the result in @frame.
+ *
+ * Drivers can call this for every frame as it arrives and then use
+ * fpi_finish_movement_estimation() once the swipe is complete instead
+ * of fpi_do_movement_estimation(). This way the expensive part of the
+ * estimation happens while the finger is still on the sensor.
+ */
+void
+fpi_estimate_frame_movement (struct fpi_frame_asmbl_ctx *ctx,
+                             struct fpi_frame           *prev_frame,
+                             struct fpi_frame           *frame)
+{
+  frame->fwd_delta_x = frame->delta_x;
+  frame->fwd_delta_y = frame->delta_y;
+  find_overlap (ctx, frame, prev_frame,
+                &frame->fwd_delta_x, &frame->fwd_delta_y,
+                &frame->fwd_error);
+
+  frame->rev_delta_x = -frame->fwd_delta_x;
+  frame->rev_delta_y = -frame->fwd_delta_y;
+  find_overlap (ctx, prev_frame, frame,
+                &frame->rev_delta_x, &frame->rev_delta_y,
+                &frame->rev_error);
+  frame->rev_delta_x = -frame->rev_delta_x;
+  frame->rev_delta_y = -frame->rev_delta_y;
+}
+
+/**
+ * fpi_finish_movement_estimation:
+ * @ctx: #fpi_frame_asmbl_ctx - frame assembling context
+ * @stripes: a singly-linked list of #fpi_frame
+ *
+ * Populates @delta_x and @delta_y of each #fpi_frame in @stripes from
+ * the estimates previously stored by fpi_estimate_frame_movement(),
+ * picking the swipe direction with the smaller overall error.
+ */
+void
+fpi_finish_movement_estimation (struct fpi_frame_asmbl_ctx *ctx,
+                                GSList                     *stripes)
 {
   GSList *l;
-  GTimer *timer;
   guint num_frames = 1;
-  struct fpi_frame *prev_stripe;
-  unsigned int min_error;
   /* Max error is width * height * 255, for AES2501 which has the largest
    * sensor its 192*16*255 = 783360. So for 32bit value it's ~5482 frame before
    * we might get int overflow. Use 64bit value here to prevent integer overflow
    */
   unsigned long long total_error = 0;
+  unsigned long long total_rev_error = 0;
+  int err, rev_err;
 
-  timer = g_timer_new ();
+  for (l = stripes->next; l != NULL; l = l->next, num_frames++)
+    {
+      struct fpi_frame *cur_stripe = l->data;
 
-  /* Skip the first frame */
-  prev_stripe = stripes->data;
+      total_error += cur_stripe->fwd_error;
+      total_rev_error += cur_stripe->rev_error;
+    }
 
-  for (l = stripes->next; l != NULL; l = l->next, num_frames++)
+  err = total_error / num_frames;
+  rev_err = total_rev_error / num_frames;
+  fp_dbg ("errors: %d rev: %d", err, rev_err);
+
+  for (l = stripes->next; l != NULL; l = l->next)
     {
       struct fpi_frame *cur_stripe = l->data;
 
-      if (reverse)
+      if (err < rev_err)
         {
-          find_overlap (ctx, prev_stripe, cur_stripe,
-                        &cur_stripe->delta_x, &cur_stripe->delta_y,
-                        &min_error);
-          cur_stripe->delta_y = -cur_stripe->delta_y;
-          cur_stripe->delta_x = -cur_stripe->delta_x;
+          cur_stripe->delta_x = cur_stripe->fwd_delta_x;
+          cur_stripe->delta_y = cur_stripe->fwd_delta_y;
         }
       else
         {
-          find_overlap (ctx, cur_stripe, prev_stripe,
-                        &cur_stripe->delta_x, &cur_stripe->delta_y,
-                        &min_error);
+          cur_stripe->delta_x = cur_stripe->rev_delta_x;
+          cur_stripe->delta_y = cur_stripe->rev_delta_y;
         }
-      total_error += min_error;
-
-      prev_stripe = cur_stripe;
     }
-
-  g_timer_stop (timer);
-  fp_dbg ("calc delta completed in %f secs", g_timer_elapsed (timer, NULL));
-  g_timer_destroy (timer);
-
-  return total_error / num_frames;
 }
 
 /**
@@ -195,13 +231,28 @@ void
 fpi_do_movement_estimation (struct fpi_frame_asmbl_ctx *ctx,
                             GSList                     *stripes)
 {
-  int err, rev_err;
+  GSList *l;
+  GTimer *timer;
+  struct fpi_frame *prev_stripe;
 
-  err = do_movement_estimation (ctx, stripes, FALSE);
-  rev_err = do_movement_estimation (ctx, stripes, TRUE);
-  fp_dbg ("errors: %d rev: %d", err, rev_err);
-  if (err < rev_err)
-    do_movement_estimation (ctx, stripes, FALSE);
+  timer = g_timer_new ();
+
+  /* Skip the first frame */
+  prev_stripe = stripes->data;
+
+  for (l = stripes->next; l != NULL; l = l->next)
+    {
+      struct fpi_frame *cur_stripe = l->data;
+
+      fpi_estimate_frame_movement (ctx, prev_stripe, cur_stripe);
+      prev_stripe = cur_stripe;
+    }
+
+  g_timer_stop (timer);
+  fp_dbg ("calc delta completed in %f secs", g_timer_elapsed (timer, NULL));
+  g_timer_destroy (timer);
+
+  fpi_finish_movement_estimation (ctx, stripes);
 }
 
 static inline void
@@ -35,6 +35,16 @@ struct fpi_frame
 {
   int           delta_x;
   int           delta_y;
+
+  /*< private >*/
+  int           fwd_delta_x;
+  int           fwd_delta_y;
+  unsigned int  fwd_error;
+  int           rev_delta_x;
+  int           rev_delta_y;
+  unsigned int  rev_error;
+
+  /*< public >*/
   unsigned char data[0];
 };
 
@@ -66,6 +76,13 @@ struct fpi_frame_asmbl_ctx
 void fpi_do_movement_estimation (struct fpi_frame_asmbl_ctx *ctx,
                                  GSList                     *stripes);
 
+void fpi_estimate_frame_movement (struct fpi_frame_asmbl_ctx *ctx,
+                                  struct fpi_frame           *prev_frame,
+                                  struct fpi_frame           *frame);
+
+void fpi_finish_movement_estimation (struct fpi_frame_asmbl_ctx *ctx,
+                                     GSList                     *stripes);
+
 FpImage *fpi_assemble_frames (struct fpi_frame_asmbl_ctx *ctx,
                               GSList                     *stripes);
 
@@ -0,0 +1,223 @@
+/*
+ * FPrint background subtraction helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "fpi-background.h"
+
+/**
+ * SECTION:fpi-background
+ * @title: Background subtraction
+ * @short_description: Background removal and finger detection for frames
+ *
+ * Many sensors, in particular swipe sensors, return frames that contain a
+ * fixed pattern even if no finger is present. Drivers capture this
+ * background while the sensor is idle, subtract it from every frame and
+ * use the remaining energy to decide whether a finger is present.
+ *
+ * The loops are branch free and operate on plain arrays, so that the
+ * compiler can vectorize them. Sums are accumulated in 32 bit blocks,
+ * which keeps the vector lanes narrow.
+ *
+ * |[<!-- language="C" -->
+ *   energy = fpi_background_subtract_u8 (frame, self->background,
+ *                                        n_pixels, MARGIN);
+ *   if (fpi_background_finger_present (energy, n_pixels, MIN_MEAN))
+ *     ...
+ * ]|
+ */
+
+/* The sum of a block of 16 bit values cannot overflow 32 bits */
+#define BLOCK_PIXELS 65536
+
+/**
+ * fpi_background_update_min_u8:
+ * @background: (array length=n_pixels): The background estimate
+ * @frame: (array length=n_pixels): A frame without a finger
+ * @n_pixels: Number of pixels
+ *
+ * Lowers every pixel of @background to the value in @frame if that is
+ * smaller. Initialize @background to 255 and feed it a number of empty
+ * frames to estimate the noise floor of the sensor.
+ */
+void
+fpi_background_update_min_u8 (guint8       *background,
+                              const guint8 *frame,
+                              gsize         n_pixels)
+{
+  guint8 *restrict bg = background;
+  const guint8 *restrict f = frame;
+  gsize i;
+
+  for (i = 0; i < n_pixels; i++)
+    bg[i] = MIN (bg[i], f[i]);
+}
+
+/**
+ * fpi_background_subtract_u8:
+ * @frame: (array length=n_pixels): The frame, modified in place
+ * @background: (array length=n_pixels): The background to remove
+ * @n_pixels: Number of pixels
+ * @margin: Differences up to this value are considered noise
+ *
+ * Subtracts @background from @frame. Pixels that are not more than
+ * @margin above the background are set to zero.
+ *
+ * Returns: The energy of the resulting frame, i.e. the sum of all pixels
+ */
+guint64
+fpi_background_subtract_u8 (guint8       *frame,
+                            const guint8 *background,
+                            gsize         n_pixels,
+                            guint8        margin)
+{
+  guint8 *restrict f = frame;
+  const guint8 *restrict bg = background;
+  guint64 energy = 0;
+  gsize start, i;
+
+  for (start = 0; start < n_pixels; start += BLOCK_PIXELS)
+    {
+      gsize end = MIN (start + BLOCK_PIXELS, n_pixels);
+      guint32 block = 0;
+
+      for (i = start; i < end; i++)
+        {
+          gint d = (gint) f[i] - bg[i];
+
+          f[i] = d > margin ? d : 0;
+          block += f[i];
+        }
+
+      energy += block;
+    }
+
+  return energy;
+}
+
+/**
+ * fpi_background_subtract_u16:
+ * @frame: (array length=n_pixels): The frame, modified in place
+ * @background: (array length=n_pixels): The background to remove
+ * @n_pixels: Number of pixels
+ * @margin: Differences up to this value are considered noise
+ *
+ * The same as fpi_background_subtract_u8() for sensors with a higher
+ * resolution.
+ *
+ * Returns: The energy of the resulting frame, i.e. the sum of all pixels
+ */
+guint64
+fpi_background_subtract_u16 (guint16       *frame,
+                             const guint16 *background,
+                             gsize          n_pixels,
+                             guint16        margin)
+{
+  guint16 *restrict f = frame;
+  const guint16 *restrict bg = background;
+  guint64 energy = 0;
+  gsize start, i;
+
+  for (start = 0; start < n_pixels; start += BLOCK_PIXELS)
+    {
+      gsize end = MIN (start + BLOCK_PIXELS, n_pixels);
+      guint32 block = 0;
+
+      for (i = start; i < end; i++)
+        {
+          gint32 d = (gint32) f[i] - bg[i];
+
+          f[i] = d > margin ? d : 0;
+          block += f[i];
+        }
+
+      energy += block;
+    }
+
+  return energy;
+}
+
+/**
+ * fpi_background_sum_u16:
+ * @frame: (array length=n_pixels): The frame
+ * @n_pixels: Number of pixels
+ *
+ * Sums up all pixels of @frame, e.g. to calculate the mean of a
+ * background.
+ *
+ * Returns: The sum of all pixels
+ */
+guint64
+fpi_background_sum_u16 (const guint16 *frame,
+                        gsize          n_pixels)
+{
+  guint64 sum = 0;
+  gsize start, i;
+
+  for (start = 0; start < n_pixels; start += BLOCK_PIXELS)
+    {
+      gsize end = MIN (start + BLOCK_PIXELS, n_pixels);
+      guint32 block = 0;
+
+      for (i = start; i < end; i++)
+        block += frame[i];
+
+      sum += block;
+    }
+
+  return sum;
+}
+
+/**
+ * fpi_background_clamp_u8:
+ * @pixels: (array length=n_pixels): The pixels, modified in place
+ * @n_pixels: Number of pixels
+ * @threshold: Highest value that is kept
+ *
+ * Sets all pixels above @threshold to white, e.g. to remove noise from
+ * areas that the finger does not touch.
+ */
+void
+fpi_background_clamp_u8 (guint8 *pixels,
+                         gsize   n_pixels,
+                         guint8  threshold)
+{
+  gsize i;
+
+  for (i = 0; i < n_pixels; i++)
+    pixels[i] = pixels[i] > threshold ? 255 : pixels[i];
+}
+
+/**
+ * fpi_background_finger_present:
+ * @energy: Energy as returned by fpi_background_subtract_u8()
+ * @n_pixels: Number of pixels in the frame
+ * @min_mean: Mean pixel value that indicates a finger
+ *
+ * Decides whether a frame contains a finger after the background has
+ * been removed.
+ *
+ * Returns: Whether the mean pixel value exceeds @min_mean
+ */
+gboolean
+fpi_background_finger_present (guint64 energy,
+                               gsize   n_pixels,
+                               guint   min_mean)
+{
+  g_return_val_if_fail (n_pixels > 0, FALSE);
+
+  return energy / n_pixels > min_mean;
+}
@@ -0,0 +1,49 @@
+/*
+ * FPrint background subtraction helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void    fpi_background_update_min_u8 (guint8       *background,
+                                      const guint8 *frame,
+                                      gsize         n_pixels);
+
+guint64 fpi_background_subtract_u8 (guint8       *frame,
+                                    const guint8 *background,
+                                    gsize         n_pixels,
+                                    guint8        margin);
+guint64 fpi_background_subtract_u16 (guint16       *frame,
+                                     const guint16 *background,
+                                     gsize          n_pixels,
+                                     guint16        margin);
+
+guint64 fpi_background_sum_u16 (const guint16 *frame,
+                                gsize          n_pixels);
+
+void    fpi_background_clamp_u8 (guint8 *pixels,
+                                 gsize   n_pixels,
+                                 guint8  threshold);
+
+gboolean fpi_background_finger_present (guint64 energy,
+                                        gsize   n_pixels,
+                                        guint   min_mean);
+
+G_END_DECLS
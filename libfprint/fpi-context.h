@@ -33,3 +33,53 @@
  *   all driver types
  */
 GArray *fpi_get_driver_types (void);
+
+/**
+ * FpiDriverInfo:
+ * @id: The driver ID, identical to the #FpDeviceClass id
+ * @type: The #FpDeviceType of the driver
+ * @get_type: Function returning the #GType of the driver
+ *
+ * Static information about a driver that is generated at build time. It
+ * allows selecting drivers without initializing their classes.
+ */
+typedef struct
+{
+  const char  *id;
+  FpDeviceType type;
+  GType (*get_type) (void);
+} FpiDriverInfo;
+
+/**
+ * fpi_get_driver_infos:
+ * @n_drivers: (out): Return location for the number of drivers
+ *
+ * This function is purely for private used.
+ *
+ * Stability: private
+ * Returns: (array length=n_drivers) (transfer none): the #FpiDriverInfo
+ *   of all drivers
+ */
+const FpiDriverInfo *fpi_get_driver_infos (guint *n_drivers);
+
+/**
+ * FpiUsbIdEntry:
+ * @vid: The USB vendor ID
+ * @pid: The USB product ID
+ * @driver: The ID of the driver supporting the device
+ *
+ * Entry of the USB ID table generated at build time from the
+ * #FpDeviceClass id_table of all USB drivers.
+ */
+typedef struct
+{
+  guint16     vid;
+  guint16     pid;
+  const char *driver;
+} FpiUsbIdEntry;
+
+/* Terminated by an entry with a %NULL driver. Only valid if
+ * fpi_usb_id_table_valid is set, which is not the case when cross
+ * compiling as the table cannot be generated then. */
+extern const FpiUsbIdEntry fpi_usb_id_table[];
+extern const gboolean fpi_usb_id_table_valid;
@@ -0,0 +1,274 @@
+/*
+ * FPrint CRC helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "fpi-crc.h"
+#include "fpi-byte-utils.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+/**
+ * SECTION:fpi-crc
+ * @title: CRC helpers
+ * @short_description: Table driven CRC calculation
+ *
+ * Many devices protect their protocol packets using a CRC. These helpers
+ * implement CRC8, CRC16 and CRC32 algorithms, both in normal and reflected
+ * form, so that drivers do not need to carry their own implementation.
+ *
+ * The calculation processes eight bytes at a time using slice-by-8 lookup
+ * tables. When building for ARMv8 with the CRC extension, the reflected
+ * CRC32 using the IEEE 802.3 polynomial is calculated using the dedicated
+ * instructions instead.
+ *
+ * |[<!-- language="C" -->
+ *   static FpiCrc crc16 = FPI_CRC_INIT (16, 0x1021, 0x0000, 0x0000, FALSE);
+ *
+ *   guint16 value = fpi_crc_compute (&crc16, buffer, length);
+ * ]|
+ */
+
+#define CRC32_IEEE_POLY 0x04C11DB7
+
+static guint32
+reflect_bits (guint32 value, guint n_bits)
+{
+  guint32 res = 0;
+  guint i;
+
+  for (i = 0; i < n_bits; i++)
+    {
+      res = (res << 1) | (value & 1);
+      value >>= 1;
+    }
+
+  return res;
+}
+
+static guint32 *
+generate_tables (const FpiCrc *crc)
+{
+  guint32 *tables = g_new (guint32, 8 * 256);
+  guint32 poly;
+  guint i, k;
+
+  /* The first table is the classic byte-wise table, table k contains the
+   * contribution of a byte followed by k zero bytes.
+   * Normal CRCs are kept in the top bits of the register, which allows
+   * sharing the code between all widths.
+   */
+  if (crc->reflected)
+    {
+      poly = reflect_bits (crc->poly, crc->width);
+
+      for (i = 0; i < 256; i++)
+        {
+          guint32 r = i;
+
+          for (k = 0; k < 8; k++)
+            r = (r & 1) ? (r >> 1) ^ poly : r >> 1;
+          tables[i] = r;
+        }
+
+      for (k = 1; k < 8; k++)
+        for (i = 0; i < 256; i++)
+          {
+            guint32 prev = tables[(k - 1) * 256 + i];
+
+            tables[k * 256 + i] = (prev >> 8) ^ tables[prev & 0xff];
+          }
+    }
+  else
+    {
+      poly = crc->poly << (32 - crc->width);
+
+      for (i = 0; i < 256; i++)
+        {
+          guint32 r = i << 24;
+
+          for (k = 0; k < 8; k++)
+            r = (r & 0x80000000) ? (r << 1) ^ poly : r << 1;
+          tables[i] = r;
+        }
+
+      for (k = 1; k < 8; k++)
+        for (i = 0; i < 256; i++)
+          {
+            guint32 prev = tables[(k - 1) * 256 + i];
+
+            tables[k * 256 + i] = (prev << 8) ^ tables[prev >> 24];
+          }
+    }
+
+  return tables;
+}
+
+static const guint32 *
+get_tables (FpiCrc *crc)
+{
+  if (g_once_init_enter (&crc->tables))
+    g_once_init_leave (&crc->tables, generate_tables (crc));
+
+  return crc->tables;
+}
+
+#if defined(__ARM_FEATURE_CRC32)
+static guint32
+update_crc32_arm (guint32 state, const guint8 *data, gsize len)
+{
+  while (len >= 8)
+    {
+      state = __crc32d (state, FP_READ_UINT64_LE (data));
+      data += 8;
+      len -= 8;
+    }
+
+  while (len--)
+    state = __crc32b (state, *data++);
+
+  return state;
+}
+#endif
+
+/**
+ * fpi_crc_start:
+ * @crc: The #FpiCrc algorithm
+ *
+ * Returns the initial state to pass to fpi_crc_update().
+ *
+ * Returns: The initial CRC state
+ */
+guint32
+fpi_crc_start (FpiCrc *crc)
+{
+  g_return_val_if_fail (crc->width == 8 || crc->width == 16 || crc->width == 32, 0);
+
+  if (crc->reflected)
+    return reflect_bits (crc->init, crc->width);
+  else
+    return crc->init << (32 - crc->width);
+}
+
+/**
+ * fpi_crc_update:
+ * @crc: The #FpiCrc algorithm
+ * @state: The current CRC state
+ * @data: (array length=len): The data to process
+ * @len: The length of @data
+ *
+ * Feeds @data into the CRC calculation.
+ *
+ * Returns: The updated CRC state
+ */
+guint32
+fpi_crc_update (FpiCrc       *crc,
+                guint32       state,
+                const guint8 *data,
+                gsize         len)
+{
+  const guint32 *t = get_tables (crc);
+
+  if (crc->reflected)
+    {
+#if defined(__ARM_FEATURE_CRC32)
+      if (crc->width == 32 && crc->poly == CRC32_IEEE_POLY)
+        return update_crc32_arm (state, data, len);
+#endif
+
+      while (len >= 8)
+        {
+          guint32 lo = state ^ FP_READ_UINT32_LE (data);
+
+          state = t[7 * 256 + (lo & 0xff)] ^
+                  t[6 * 256 + ((lo >> 8) & 0xff)] ^
+                  t[5 * 256 + ((lo >> 16) & 0xff)] ^
+                  t[4 * 256 + (lo >> 24)] ^
+                  t[3 * 256 + data[4]] ^
+                  t[2 * 256 + data[5]] ^
+                  t[1 * 256 + data[6]] ^
+                  t[data[7]];
+          data += 8;
+          len -= 8;
+        }
+
+      while (len--)
+        state = (state >> 8) ^ t[(state ^ *data++) & 0xff];
+    }
+  else
+    {
+      while (len >= 8)
+        {
+          guint32 hi = state ^ FP_READ_UINT32_BE (data);
+
+          state = t[7 * 256 + (hi >> 24)] ^
+                  t[6 * 256 + ((hi >> 16) & 0xff)] ^
+                  t[5 * 256 + ((hi >> 8) & 0xff)] ^
+                  t[4 * 256 + (hi & 0xff)] ^
+                  t[3 * 256 + data[4]] ^
+                  t[2 * 256 + data[5]] ^
+                  t[1 * 256 + data[6]] ^
+                  t[data[7]];
+          data += 8;
+          len -= 8;
+        }
+
+      while (len--)
+        state = (state << 8) ^ t[(state >> 24) ^ *data++];
+    }
+
+  return state;
+}
+
+/**
+ * fpi_crc_finish:
+ * @crc: The #FpiCrc algorithm
+ * @state: The current CRC state
+ *
+ * Converts the state returned by fpi_crc_update() into the final CRC value.
+ *
+ * Returns: The CRC value
+ */
+guint32
+fpi_crc_finish (FpiCrc *crc, guint32 state)
+{
+  if (crc->reflected)
+    return state ^ crc->xorout;
+  else
+    return (state >> (32 - crc->width)) ^ crc->xorout;
+}
+
+/**
+ * fpi_crc_compute:
+ * @crc: The #FpiCrc algorithm
+ * @data: (array length=len): The data to process
+ * @len: The length of @data
+ *
+ * Calculates the CRC of @data in one go.
+ *
+ * Returns: The CRC value
+ */
+guint32
+fpi_crc_compute (FpiCrc *crc, const guint8 *data, gsize len)
+{
+  guint32 state = fpi_crc_start (crc);
+
+  state = fpi_crc_update (crc, state, data, len);
+
+  return fpi_crc_finish (crc, state);
+}
@@ -0,0 +1,78 @@
+/*
+ * FPrint CRC helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * FpiCrc:
+ * @width: Width of the CRC in bits, 8, 16 or 32
+ * @poly: Generator polynomial in normal (MSB first) notation
+ * @init: Initial value of the CRC register
+ * @xorout: Value XOR'ed to the final register value
+ * @reflected: Whether input bytes and result are bit reflected
+ *
+ * Description of a CRC algorithm using the common Rocksoft model, with
+ * reflected input always implying a reflected output. Drivers should
+ * declare these as static variables using FPI_CRC_INIT(); the lookup
+ * tables are generated on first use and shared by all users of the
+ * structure.
+ */
+typedef struct
+{
+  guint8   width;
+  guint32  poly;
+  guint32  init;
+  guint32  xorout;
+  gboolean reflected;
+
+  /*< private >*/
+  guint32 *tables;
+} FpiCrc;
+
+/**
+ * FPI_CRC_INIT:
+ * @width: Width of the CRC in bits, 8, 16 or 32
+ * @poly: Generator polynomial in normal (MSB first) notation
+ * @init: Initial value of the CRC register
+ * @xorout: Value XOR'ed to the final register value
+ * @reflected: Whether input bytes and result are bit reflected
+ *
+ * Static initializer for an #FpiCrc.
+ */
+#define FPI_CRC_INIT(width, poly, init, xorout, reflected) \
+  { (width), (poly), (init), (xorout), (reflected), NULL }
+
+guint32 fpi_crc_start (FpiCrc *crc);
+
+guint32 fpi_crc_update (FpiCrc       *crc,
+                        guint32       state,
+                        const guint8 *data,
+                        gsize         len);
+
+guint32 fpi_crc_finish (FpiCrc *crc,
+                        guint32 state);
+
+guint32 fpi_crc_compute (FpiCrc       *crc,
+                         const guint8 *data,
+                         gsize         len);
+
+G_END_DECLS
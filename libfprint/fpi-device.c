@@ -346,6 +346,17 @@ static GSourceFuncs timeout_funcs = {
   NULL, NULL
 };
 
+static GMainContext *
+get_timeout_context (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  if (priv->current_task)
+    return g_task_get_context (priv->current_task);
+  else
+    return g_main_context_get_thread_default ();
+}
+
 /**
  * fpi_device_add_timeout:
  * @device: The #FpDevice
@@ -357,6 +368,9 @@ static GSourceFuncs timeout_funcs = {
  * Register a timeout to run. Drivers should always make sure that timers are
  * cancelled when appropriate.
  *
+ * Consider using fpi_device_add_timer() for short lived timers that do not
+ * need to be a #GSource of their own.
+ *
  * Returns: (transfer none): A newly created and attached #GSource
  */
 GSource *
@@ -368,18 +382,12 @@ fpi_device_add_timeout (FpDevice      *device,
 {
   FpDevicePrivate *priv = fp_device_get_instance_private (device);
   FpDeviceTimeoutSource *source;
-  GMainContext *context;
 
   source = (FpDeviceTimeoutSource *) g_source_new (&timeout_funcs,
                                                    sizeof (FpDeviceTimeoutSource));
   source->device = device;
 
-  if (priv->current_task)
-    context = g_task_get_context (priv->current_task);
-  else
-    context = g_main_context_get_thread_default ();
-
-  g_source_attach (&source->source, context);
+  g_source_attach (&source->source, get_timeout_context (device));
   g_source_set_callback (&source->source, (GSourceFunc) func, user_data, destroy_notify);
   g_source_set_ready_time (&source->source,
                            g_source_get_time (&source->source) + interval * (guint64) 1000);
@@ -389,6 +397,275 @@ fpi_device_add_timeout (FpDevice      *device,
   return &source->source;
 }
 
+typedef struct
+{
+  guint          id;
+  gint64         deadline;
+  FpTimeoutFunc  func;
+  gpointer       user_data;
+  GDestroyNotify destroy_notify;
+} FpDeviceTimer;
+
+static void
+fp_device_timer_free (FpDeviceTimer *timer)
+{
+  if (timer->destroy_notify)
+    timer->destroy_notify (timer->user_data);
+
+  g_free (timer);
+}
+
+static gint
+fp_device_timer_compare (gconstpointer a, gconstpointer b)
+{
+  const FpDeviceTimer *timer_a = a;
+  const FpDeviceTimer *timer_b = b;
+
+  if (timer_a->deadline != timer_b->deadline)
+    return timer_a->deadline < timer_b->deadline ? -1 : 1;
+
+  /* IDs only wrap after billions of timers, ignore that for ordering */
+  if (timer_a->id != timer_b->id)
+    return timer_a->id < timer_b->id ? -1 : 1;
+
+  return 0;
+}
+
+typedef struct
+{
+  GSource   source;
+  FpDevice *device;
+  GList    *timers;
+} FpDeviceTimerQueue;
+
+static void
+timer_queue_rearm (FpDeviceTimerQueue *queue)
+{
+  FpDeviceTimer *next;
+
+  if (!queue->timers)
+    {
+      g_source_set_ready_time (&queue->source, -1);
+      return;
+    }
+
+  next = queue->timers->data;
+  g_source_set_ready_time (&queue->source, next->deadline);
+}
+
+static gboolean
+timer_queue_dispatch (GSource *source, GSourceFunc gsource_func, gpointer user_data)
+{
+  FpDeviceTimerQueue *queue = (FpDeviceTimerQueue *) source;
+  g_autoptr(FpDevice) device = g_object_ref (queue->device);
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  gint64 now = g_source_get_time (source);
+  guint last_id = priv->timer_last_id;
+
+  /* Run everything that is due. Timers added from a callback always sort
+   * after the ones that were due when we started, stop at those so that a
+   * zero interval timer re-adding itself does not starve the main loop. */
+  while (queue->timers)
+    {
+      FpDeviceTimer *timer = queue->timers->data;
+
+      if (timer->deadline > now || timer->id > last_id)
+        break;
+
+      queue->timers = g_list_delete_link (queue->timers, queue->timers);
+
+      timer->func (device, timer->user_data);
+      fp_device_timer_free (timer);
+    }
+
+  timer_queue_rearm (queue);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+timer_queue_finalize (GSource *source)
+{
+  FpDeviceTimerQueue *queue = (FpDeviceTimerQueue *) source;
+
+  g_list_free_full (g_steal_pointer (&queue->timers),
+                    (GDestroyNotify) fp_device_timer_free);
+}
+
+static GSourceFuncs timer_queue_funcs = {
+  NULL, /* prepare */
+  NULL, /* check */
+  timer_queue_dispatch,
+  timer_queue_finalize,
+  NULL, NULL
+};
+
+static void
+timer_queue_destroy (FpDeviceTimerQueue *queue)
+{
+  /* Free the timers right away rather than whenever the context lets go
+   * of the source, user data may reference the device. */
+  g_list_free_full (g_steal_pointer (&queue->timers),
+                    (GDestroyNotify) fp_device_timer_free);
+  g_source_destroy (&queue->source);
+  g_source_unref (&queue->source);
+}
+
+static FpDeviceTimerQueue *
+timer_queue_ensure (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  GMainContext *context = get_timeout_context (device);
+  FpDeviceTimerQueue *found = NULL;
+  GSList *l = priv->timer_queues;
+
+  /* Timers always run in the context they were added from. Keep one queue
+   * per context and drop idle queues of contexts that are no longer used,
+   * so that a device which moves between threads does not accumulate them. */
+  while (l)
+    {
+      FpDeviceTimerQueue *queue = l->data;
+      GSList *next = l->next;
+
+      if (g_source_get_context (&queue->source) == context)
+        {
+          found = queue;
+        }
+      else if (!queue->timers)
+        {
+          priv->timer_queues = g_slist_delete_link (priv->timer_queues, l);
+          timer_queue_destroy (queue);
+        }
+
+      l = next;
+    }
+
+  if (found)
+    return found;
+
+  found = (FpDeviceTimerQueue *) g_source_new (&timer_queue_funcs,
+                                               sizeof (FpDeviceTimerQueue));
+  found->device = device;
+  g_source_set_name (&found->source, "fpi device timers");
+  g_source_set_ready_time (&found->source, -1);
+  g_source_attach (&found->source, context);
+
+  priv->timer_queues = g_slist_prepend (priv->timer_queues, found);
+
+  return found;
+}
+
+/**
+ * fpi_device_add_timer:
+ * @device: The #FpDevice
+ * @interval: The interval in milliseconds
+ * @func: The #FpTimeoutFunc to call on timeout
+ * @user_data: (nullable): User data to pass to the callback
+ * @destroy_notify: (nullable): #GDestroyNotify for @user_data
+ *
+ * Register a timeout to run, similar to fpi_device_add_timeout(). All
+ * timers of a device that are added from the same #GMainContext share a
+ * single #GSource which is only woken up for the earliest deadline, making
+ * this cheaper for the many short lived timers that drivers use for polling
+ * and delays.
+ *
+ * Timers that are due at the same time run in the order they were added.
+ * @destroy_notify is called right after @func ran or when the timer is
+ * removed using fpi_device_remove_timer().
+ *
+ * Returns: A non-zero handle to cancel the timer with
+ */
+guint
+fpi_device_add_timer (FpDevice      *device,
+                      gint           interval,
+                      FpTimeoutFunc  func,
+                      gpointer       user_data,
+                      GDestroyNotify destroy_notify)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  FpDeviceTimerQueue *queue;
+  FpDeviceTimer *timer;
+
+  g_return_val_if_fail (FP_IS_DEVICE (device), 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  queue = timer_queue_ensure (device);
+
+  timer = g_new0 (FpDeviceTimer, 1);
+  timer->id = ++priv->timer_last_id;
+  if (timer->id == 0)
+    timer->id = ++priv->timer_last_id;
+  timer->deadline = g_source_get_time (&queue->source) +
+                    MAX (interval, 0) * (guint64) 1000;
+  timer->func = func;
+  timer->user_data = user_data;
+  timer->destroy_notify = destroy_notify;
+
+  queue->timers = g_list_insert_sorted (queue->timers, timer,
+                                        fp_device_timer_compare);
+  if (queue->timers->data == timer)
+    timer_queue_rearm (queue);
+
+  return timer->id;
+}
+
+/**
+ * fpi_device_remove_timer:
+ * @device: The #FpDevice
+ * @id: A handle returned by fpi_device_add_timer()
+ *
+ * Cancels a timer that has not run yet.
+ *
+ * Returns: %TRUE if the timer was pending and has been removed
+ */
+gboolean
+fpi_device_remove_timer (FpDevice *device,
+                         guint     id)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  GSList *q;
+  GList *l;
+
+  g_return_val_if_fail (FP_IS_DEVICE (device), FALSE);
+
+  if (id == 0)
+    return FALSE;
+
+  for (q = priv->timer_queues; q; q = q->next)
+    {
+      FpDeviceTimerQueue *queue = q->data;
+
+      for (l = queue->timers; l; l = l->next)
+        {
+          FpDeviceTimer *timer = l->data;
+          gboolean was_first;
+
+          if (timer->id != id)
+            continue;
+
+          was_first = l == queue->timers;
+          queue->timers = g_list_delete_link (queue->timers, l);
+          if (was_first)
+            timer_queue_rearm (queue);
+
+          fp_device_timer_free (timer);
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Purely internal, used on finalize */
+void
+fpi_device_clear_timers (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  g_slist_free_full (g_steal_pointer (&priv->timer_queues),
+                     (GDestroyNotify) timer_queue_destroy);
+}
+
 /**
  * fpi_device_get_usb_device:
  * @device: The #FpDevice
@@ -522,6 +799,107 @@ fpi_device_get_driver_data (FpDevice *device)
   return priv->driver_data;
 }
 
+/**
+ * fpi_device_set_calibration:
+ * @device: The #FpDevice
+ * @key: A string identifying the sensor, e.g. its serial and firmware version
+ * @data: (transfer none): The calibration blob
+ *
+ * Stores the result of a sensor calibration so that later activations can
+ * skip it, see fpi_device_get_calibration(). The data should be self
+ * contained, as the API user may persist it across process restarts using
+ * fp_device_get_calibration_data().
+ *
+ * The current time and device temperature are recorded together with the
+ * data.
+ */
+void
+fpi_device_set_calibration (FpDevice   *device,
+                            const char *key,
+                            GBytes     *data)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  g_return_if_fail (FP_IS_DEVICE (device));
+  g_return_if_fail (key != NULL);
+  g_return_if_fail (data != NULL);
+
+  g_free (priv->calibration_key);
+  priv->calibration_key = g_strdup (key);
+  g_clear_pointer (&priv->calibration_data, g_bytes_unref);
+  priv->calibration_data = g_bytes_ref (data);
+  priv->calibration_time = g_get_real_time ();
+  priv->calibration_temp = priv->temp_current;
+}
+
+/**
+ * fpi_device_get_calibration:
+ * @device: The #FpDevice
+ * @key: The key that was passed to fpi_device_set_calibration()
+ * @max_age_seconds: Maximum age of the calibration, or -1 for no limit
+ *
+ * Retrieves a calibration that was stored earlier. It is only returned if
+ * @key matches, if it is not older than @max_age_seconds and if the device
+ * temperature is still the same as when it was created.
+ *
+ * Returns: (transfer full) (nullable): The calibration blob or %NULL
+ */
+GBytes *
+fpi_device_get_calibration (FpDevice   *device,
+                            const char *key,
+                            gint64      max_age_seconds)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  gint64 age;
+
+  g_return_val_if_fail (FP_IS_DEVICE (device), NULL);
+  g_return_val_if_fail (key != NULL, NULL);
+
+  if (!priv->calibration_data)
+    return NULL;
+
+  if (g_strcmp0 (priv->calibration_key, key) != 0)
+    {
+      g_debug ("Not using cached calibration for a different sensor");
+      return NULL;
+    }
+
+  /* Also reject calibrations from the future, the clock might have jumped */
+  age = g_get_real_time () - priv->calibration_time;
+  if (age < 0 || (max_age_seconds >= 0 && age > max_age_seconds * G_USEC_PER_SEC))
+    {
+      g_debug ("Not using cached calibration that is %" G_GINT64_FORMAT " seconds old",
+               age / G_USEC_PER_SEC);
+      return NULL;
+    }
+
+  if (priv->calibration_temp != priv->temp_current)
+    {
+      g_debug ("Not using cached calibration taken at a different temperature");
+      return NULL;
+    }
+
+  return g_bytes_ref (priv->calibration_data);
+}
+
+/**
+ * fpi_device_clear_calibration:
+ * @device: The #FpDevice
+ *
+ * Drops the stored calibration, e.g. because the images indicate that it
+ * does not fit the sensor anymore.
+ */
+void
+fpi_device_clear_calibration (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  g_return_if_fail (FP_IS_DEVICE (device));
+
+  g_clear_pointer (&priv->calibration_key, g_free);
+  g_clear_pointer (&priv->calibration_data, g_bytes_unref);
+}
+
 /**
  * fpi_device_get_enroll_data:
  * @device: The #FpDevice
@@ -964,6 +1342,18 @@ fp_device_task_return_in_idle_cb (gpointer user_data)
   g_clear_object (&priv->current_cancellable);
   cancellation_reason = g_steal_pointer (&priv->current_cancellation_reason);
 
+  /* Remember how long actions usually keep the device active */
+  if (priv->temp_active_since)
+    {
+      gint64 duration = g_get_monotonic_time () - priv->temp_active_since;
+
+      if (priv->temp_active_estimate)
+        priv->temp_active_estimate = (3 * priv->temp_active_estimate + duration) / 4;
+      else
+        priv->temp_active_estimate = duration;
+      priv->temp_active_since = 0;
+    }
+
   fpi_device_update_temp (data->device, FALSE);
 
   if (action == FPI_DEVICE_ACTION_OPEN &&
@@ -1580,6 +1970,9 @@ update_attr (const char *attr, const char *value)
   return 0;
 }
 
+static void throttle_schedule (FpDevice *device,
+                               gint64    delay);
+
 static void
 complete_suspend_resume_task (FpDevice *device)
 {
@@ -1611,7 +2004,18 @@ fpi_device_suspend (FpDevice *device)
     case FPI_DEVICE_ACTION_VERIFY:
     case FPI_DEVICE_ACTION_IDENTIFY:
     case FPI_DEVICE_ACTION_CAPTURE:
-      if (FP_DEVICE_GET_CLASS (device)->suspend)
+      /* Throttled, the driver has not been started yet. Only the rest of
+       * the pause is left once we resume. */
+      if (priv->temp_throttle_func)
+        {
+          if (priv->temp_throttle_timeout)
+            fpi_device_remove_timer (device, priv->temp_throttle_timeout);
+          priv->temp_throttle_timeout = 0;
+          priv->temp_throttle_remaining = MAX (priv->temp_throttle_deadline -
+                                               g_get_monotonic_time (), 0);
+          fpi_device_suspend_complete (device, NULL);
+        }
+      else if (FP_DEVICE_GET_CLASS (device)->suspend)
         {
           if (priv->critical_section)
             priv->suspend_queued = TRUE;
@@ -1656,7 +2060,12 @@ fpi_device_resume (FpDevice *device)
     case FPI_DEVICE_ACTION_VERIFY:
     case FPI_DEVICE_ACTION_IDENTIFY:
     case FPI_DEVICE_ACTION_CAPTURE:
-      if (FP_DEVICE_GET_CLASS (device)->resume)
+      if (priv->temp_throttle_func)
+        {
+          fpi_device_resume_complete (device, NULL);
+          throttle_schedule (device, priv->temp_throttle_remaining);
+        }
+      else if (FP_DEVICE_GET_CLASS (device)->resume)
         {
           if (priv->critical_section)
             priv->resume_queued = TRUE;
@@ -1914,6 +2323,10 @@ fpi_device_enroll_progress (FpDevice *device,
       g_clear_object (&print);
     }
 
+  fpi_device_metrics_add (device, FPI_METRIC_SCANS, 1);
+  if (error)
+    fpi_device_metrics_retry (device, error->code);
+
   data = g_task_get_task_data (priv->current_task);
 
   if (data->enroll_progress_cb)
@@ -1929,6 +2342,26 @@ fpi_device_enroll_progress (FpDevice *device,
   g_clear_object (&print);
 }
 
+static void
+report_match_metrics (FpDevice *device, FpMatchData *data)
+{
+  fpi_device_metrics_add (device, FPI_METRIC_SCANS, 1);
+
+  if (data->error)
+    {
+      if (data->error->domain == FP_DEVICE_RETRY)
+        fpi_device_metrics_retry (device, data->error->code);
+    }
+  else if (data->match)
+    {
+      fpi_device_metrics_add (device, FPI_METRIC_MATCHES, 1);
+    }
+  else
+    {
+      fpi_device_metrics_add (device, FPI_METRIC_NO_MATCHES, 1);
+    }
+}
+
 /**
  * fpi_device_verify_report:
  * @device: The #FpDevice
@@ -1988,15 +2421,19 @@ fpi_device_verify_report (FpDevice      *device,
     }
   else
     {
+      FpPrint *enrolled_print;
+
+      fpi_device_get_verify_data (device, &enrolled_print);
+      fpi_print_record_match (enrolled_print, result == FPI_MATCH_SUCCESS);
+
       if (result == FPI_MATCH_SUCCESS)
-        {
-          fpi_device_get_verify_data (device, &data->match);
-          g_object_ref (data->match);
-        }
+        data->match = g_object_ref (enrolled_print);
 
       data->print = g_steal_pointer (&print);
     }
 
+  report_match_metrics (device, data);
+
   if (call_cb && data->match_cb)
     data->match_cb (device, data->match, data->print, data->match_data, data->error);
 }
@@ -2081,12 +2518,17 @@ fpi_device_identify_report (FpDevice *device,
   else
     {
       if (match)
-        data->match = g_steal_pointer (&match);
+        {
+          fpi_print_record_match (match, TRUE);
+          data->match = g_steal_pointer (&match);
+        }
 
       if (print)
         data->print = g_steal_pointer (&print);
     }
 
+  report_match_metrics (device, data);
+
   if (call_cb && data->match_cb)
     data->match_cb (device, data->match, data->print, data->match_data, data->error);
 }
@@ -2147,11 +2589,169 @@ fpi_device_report_finger_status_changes (FpDevice           *device,
   return fpi_device_report_finger_status (device, finger_status);
 }
 
+/* The heat ratio at @now, continuing the last known state */
+static gdouble
+temp_ratio_at (FpDevicePrivate *priv, gint64 now)
+{
+  gdouble passed_seconds = (now - priv->temp_last_update) / 1e6;
+  gdouble alpha;
+
+  if (priv->temp_last_active)
+    {
+      alpha = exp (-passed_seconds / priv->temp_hot_seconds);
+      return alpha * priv->temp_current_ratio + 1 - alpha;
+    }
+  else
+    {
+      alpha = exp (-passed_seconds / priv->temp_cold_seconds);
+      return alpha * priv->temp_current_ratio;
+    }
+}
+
+/**
+ * fpi_device_get_temp_budget:
+ * @device: The #FpDevice
+ *
+ * Purely internal function to calculate how long the device may be active
+ * before it becomes too hot.
+ *
+ * Returns: The budget in microseconds or -1 if the device is not limited
+ */
+gint64
+fpi_device_get_temp_budget (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  gdouble ratio;
+
+  if (priv->temp_hot_seconds < 0)
+    return -1;
+
+  if (priv->temp_current == FP_TEMPERATURE_HOT)
+    return 0;
+
+  ratio = temp_ratio_at (priv, g_get_monotonic_time ());
+  if (ratio >= TEMP_WARM_HOT_THRESH)
+    return 0;
+
+  return priv->temp_hot_seconds *
+         log ((1.0 - ratio) / (1.0 - TEMP_WARM_HOT_THRESH)) * G_USEC_PER_SEC;
+}
+
+/**
+ * fpi_device_get_temp_throttle:
+ * @device: The #FpDevice
+ *
+ * Purely internal function to calculate how long the device needs to cool
+ * down before starting an action, so that an action of the usual duration
+ * finishes before the device becomes too hot.
+ *
+ * Returns: The required pause in microseconds
+ */
+gint64
+fpi_device_get_temp_throttle (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  gdouble window;
+  gdouble max_ratio;
+  gdouble ratio;
+
+  if (priv->temp_hot_seconds < 0 || priv->temp_active_estimate <= 0)
+    return 0;
+
+  /* Highest ratio from which the next action stays below the threshold */
+  window = TEMP_THROTTLE_MARGIN * priv->temp_active_estimate / 1e6;
+  max_ratio = 1.0 - (1.0 - TEMP_WARM_HOT_THRESH) * exp (window / priv->temp_hot_seconds);
+
+  /* Not going to fit even when cold, the action will be cut off anyway */
+  if (max_ratio <= TEMP_COLD_THRESH)
+    return 0;
+
+  ratio = temp_ratio_at (priv, g_get_monotonic_time ());
+  if (ratio <= max_ratio)
+    return 0;
+
+  return priv->temp_cold_seconds * log (ratio / max_ratio) * G_USEC_PER_SEC;
+}
+
+static void
+throttle_timeout_cb (FpDevice *device, gpointer user_data)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  void (*func) (FpDevice *device) = g_steal_pointer (&priv->temp_throttle_func);
+
+  priv->temp_throttle_timeout = 0;
+
+  if (g_cancellable_is_cancelled (priv->current_cancellable))
+    {
+      fpi_device_action_error (device,
+                               g_error_new_literal (G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                                                    "Operation was cancelled"));
+      return;
+    }
+
+  fpi_device_update_temp (device, TRUE);
+  if (priv->temp_current == FP_TEMPERATURE_HOT)
+    {
+      fpi_device_action_error (device, fpi_device_error_new (FP_DEVICE_ERROR_TOO_HOT));
+      return;
+    }
+
+  priv->temp_active_since = g_get_monotonic_time ();
+  func (device);
+}
+
+static void
+throttle_schedule (FpDevice *device,
+                   gint64    delay)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  priv->temp_throttle_deadline = g_get_monotonic_time () + delay;
+  priv->temp_throttle_timeout = fpi_device_add_timer (device,
+                                                      (delay + 999) / 1000,
+                                                      throttle_timeout_cb,
+                                                      NULL, NULL);
+}
+
+/**
+ * fpi_device_run_action:
+ * @device: The #FpDevice
+ * @func: The driver vfunc to run
+ *
+ * Purely internal function to start the driver for the current action. If
+ * the device is close to becoming too hot, the start is delayed so that the
+ * device can cool down, keeping the device usable at a reduced rate instead
+ * of cancelling the action once it becomes too hot.
+ */
+void
+fpi_device_run_action (FpDevice *device,
+                       void (*func) (FpDevice *device))
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+  gint64 delay = fpi_device_get_temp_throttle (device);
+
+  if (delay <= 0)
+    {
+      priv->temp_active_since = g_get_monotonic_time ();
+      func (device);
+      return;
+    }
+
+  g_debug ("Delaying action by %" G_GINT64_FORMAT " ms to let the device cool down",
+           delay / 1000);
+
+  /* The device is idle during the pause */
+  fpi_device_update_temp (device, FALSE);
+  priv->temp_throttle_func = func;
+  throttle_schedule (device, delay);
+}
+
 static void
 update_temp_timeout (FpDevice *device, gpointer user_data)
 {
   FpDevicePrivate *priv = fp_device_get_instance_private (device);
 
+  priv->temp_timeout = 0;
   fpi_device_update_temp (device, priv->temp_last_active);
 }
 
@@ -2169,7 +2769,6 @@ fpi_device_update_temp (FpDevice *device, gboolean is_active)
   FpDevicePrivate *priv = fp_device_get_instance_private (device);
   gint64 now = g_get_monotonic_time ();
   gdouble passed_seconds;
-  gdouble alpha;
   gdouble next_threshold;
   gdouble old_ratio;
   FpTemperature old_temp;
@@ -2184,17 +2783,7 @@ fpi_device_update_temp (FpDevice *device, gboolean is_active)
 
   passed_seconds = (now - priv->temp_last_update) / 1e6;
   old_ratio = priv->temp_current_ratio;
-
-  if (priv->temp_last_active)
-    {
-      alpha = exp (-passed_seconds / priv->temp_hot_seconds);
-      priv->temp_current_ratio = alpha * priv->temp_current_ratio + 1 - alpha;
-    }
-  else
-    {
-      alpha = exp (-passed_seconds / priv->temp_cold_seconds);
-      priv->temp_current_ratio = alpha * priv->temp_current_ratio;
-    }
+  priv->temp_current_ratio = temp_ratio_at (priv, now);
 
   priv->temp_last_active = is_active;
   priv->temp_last_update = now;
@@ -2236,7 +2825,10 @@ fpi_device_update_temp (FpDevice *device, gboolean is_active)
            new_temp_str);
 
   if (priv->temp_current != old_temp)
-    g_object_notify (G_OBJECT (device), "temperature");
+    {
+      fpi_device_metrics_temperature (device, priv->temp_current);
+      g_object_notify (G_OBJECT (device), "temperature");
+    }
 
   /* If the device is HOT, then do an internal cancellation of long running tasks. */
   if (priv->temp_current == FP_TEMPERATURE_HOT)
@@ -2253,7 +2845,9 @@ fpi_device_update_temp (FpDevice *device, gboolean is_active)
         }
     }
 
-  g_clear_pointer (&priv->temp_timeout, g_source_destroy);
+  if (priv->temp_timeout)
+    fpi_device_remove_timer (device, priv->temp_timeout);
+  priv->temp_timeout = 0;
 
   if (next_threshold < 0)
     return;
@@ -2266,8 +2860,8 @@ fpi_device_update_temp (FpDevice *device, gboolean is_active)
 
   passed_seconds += TEMP_DELAY_SECONDS;
 
-  priv->temp_timeout = fpi_device_add_timeout (device,
-                                               passed_seconds * 1000,
-                                               update_temp_timeout,
-                                               NULL, NULL);
+  priv->temp_timeout = fpi_device_add_timer (device,
+                                             passed_seconds * 1000,
+                                             update_temp_timeout,
+                                             NULL, NULL);
 }
@@ -182,7 +182,8 @@ void fpi_device_class_auto_initialize_features (FpDeviceClass *device_class);
  * @device: The #FpDevice passed to fpi_device_add_timeout()
  * @user_data: the data passed to fpi_device_add_timeout()
  *
- * The prototype of the callback function for fpi_device_add_timeout().
+ * The prototype of the callback function for fpi_device_add_timeout()
+ * and fpi_device_add_timer().
  */
 typedef void (*FpTimeoutFunc) (FpDevice *device,
                                gpointer  user_data);
@@ -239,6 +240,14 @@ GError * fpi_device_error_new_msg (FpDeviceError error,
 
 guint64 fpi_device_get_driver_data (FpDevice *device);
 
+void fpi_device_set_calibration (FpDevice   *device,
+                                 const char *key,
+                                 GBytes     *data);
+GBytes *fpi_device_get_calibration (FpDevice   *device,
+                                    const char *key,
+                                    gint64      max_age_seconds);
+void fpi_device_clear_calibration (FpDevice *device);
+
 void fpi_device_get_enroll_data (FpDevice *device,
                                  FpPrint **print);
 
@@ -259,6 +268,13 @@ GSource * fpi_device_add_timeout (FpDevice      *device,
                                   FpTimeoutFunc  func,
                                   gpointer       user_data,
                                   GDestroyNotify destroy_notify);
+guint fpi_device_add_timer (FpDevice      *device,
+                            gint           interval,
+                            FpTimeoutFunc  func,
+                            gpointer       user_data,
+                            GDestroyNotify destroy_notify);
+gboolean fpi_device_remove_timer (FpDevice *device,
+                                  guint     id);
 
 void fpi_device_set_nr_enroll_stages (FpDevice *device,
                                       gint      enroll_stages);
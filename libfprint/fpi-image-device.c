@@ -19,10 +19,13 @@
 
 #define FP_COMPONENT "image_device"
 #include "fpi-log.h"
+#include "fpi-metrics.h"
 
 #include "fp-image-device-private.h"
 #include "fp-image-device.h"
 
+#include <math.h>
+
 /**
  * SECTION: fpi-image-device
  * @title: Internal FpImageDevice
@@ -232,6 +235,281 @@ fp_image_device_maybe_complete_action (FpImageDevice *self, GError *error)
     }
 }
 
+typedef struct
+{
+  gdouble weight;
+  guint   generation;
+} MatchHistoryEntry;
+
+typedef struct
+{
+  FpPrint *print;
+  gdouble  weight;
+  gint64   last_match;
+  guint    index;
+} MatchCandidate;
+
+static gdouble
+match_history_weight (FpImageDevicePrivate *priv, const MatchHistoryEntry *entry)
+{
+  return entry->weight * exp2 (-(gdouble) (priv->match_generation - entry->generation) /
+                               IMG_MATCH_HISTORY_HALF_LIFE);
+}
+
+static gint
+match_candidate_compare (gconstpointer a, gconstpointer b)
+{
+  const MatchCandidate *candidate_a = a;
+  const MatchCandidate *candidate_b = b;
+
+  if (candidate_a->weight != candidate_b->weight)
+    return candidate_a->weight < candidate_b->weight ? 1 : -1;
+
+  /* Fall back to the persisted usage statistics, e.g. after a restart */
+  if (candidate_a->last_match != candidate_b->last_match)
+    return candidate_a->last_match < candidate_b->last_match ? 1 : -1;
+
+  /* Keep the order of the caller otherwise */
+  return (gint) candidate_a->index - (gint) candidate_b->index;
+}
+
+/* Returns the gallery with prints that matched often and recently first,
+ * using the last match time stored in the prints where there is no history.
+ * Only the order of the comparisons changes, a print that matches is still
+ * found, though a different one may be picked if several of them match. */
+static GPtrArray *
+fp_image_device_order_gallery (FpImageDevice *self, GPtrArray *templates)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+  g_autofree MatchCandidate *candidates = NULL;
+  GPtrArray *ordered;
+  gboolean have_history;
+  gboolean have_stats = FALSE;
+  guint i;
+
+  have_history = priv->match_history && g_hash_table_size (priv->match_history) > 0;
+
+  candidates = g_new (MatchCandidate, templates->len);
+  for (i = 0; i < templates->len; i++)
+    {
+      FpPrint *template = g_ptr_array_index (templates, i);
+      MatchHistoryEntry *entry = NULL;
+      GDateTime *last_match = fp_print_get_last_match (template);
+
+      if (have_history)
+        entry = g_hash_table_lookup (priv->match_history, template);
+
+      candidates[i].print = template;
+      candidates[i].weight = entry ? match_history_weight (priv, entry) : 0.0;
+      candidates[i].last_match = last_match ? g_date_time_to_unix (last_match) : 0;
+      candidates[i].index = i;
+
+      have_stats |= last_match != NULL;
+    }
+
+  if (!have_history && !have_stats)
+    return g_ptr_array_ref (templates);
+
+  qsort (candidates, templates->len, sizeof (MatchCandidate), match_candidate_compare);
+
+  ordered = g_ptr_array_sized_new (templates->len);
+  for (i = 0; i < templates->len; i++)
+    g_ptr_array_add (ordered, candidates[i].print);
+
+  return ordered;
+}
+
+static void
+fp_image_device_record_match (FpImageDevice *self, FpPrint *match)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+  MatchHistoryEntry *entry;
+
+  priv->match_generation += 1;
+
+  if (!match)
+    return;
+
+  /* The keys are copies, as the matched prints may be updated later on.
+   * Prints are compared in full, so hash collisions are not merged. */
+  if (!priv->match_history)
+    priv->match_history = g_hash_table_new_full ((GHashFunc) fpi_print_hash,
+                                                 (GEqualFunc) fp_print_equal,
+                                                 g_object_unref, g_free);
+
+  entry = g_hash_table_lookup (priv->match_history, match);
+  if (entry)
+    {
+      entry->weight = match_history_weight (priv, entry) + 1.0;
+    }
+  else
+    {
+      GHashTableIter iter;
+
+      /* Drop prints that have not been matched for a long time */
+      if (g_hash_table_size (priv->match_history) >= IMG_MATCH_HISTORY_SIZE)
+        {
+          g_hash_table_iter_init (&iter, priv->match_history);
+          while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+            if (match_history_weight (priv, entry) < 0.05)
+              g_hash_table_iter_remove (&iter);
+        }
+
+      /* Still full, forget the print with the lowest weight */
+      if (g_hash_table_size (priv->match_history) >= IMG_MATCH_HISTORY_SIZE)
+        {
+          gpointer lowest_key = NULL;
+          gdouble lowest_weight = G_MAXDOUBLE;
+          gpointer key;
+
+          g_hash_table_iter_init (&iter, priv->match_history);
+          while (g_hash_table_iter_next (&iter, &key, (gpointer *) &entry))
+            {
+              gdouble weight = match_history_weight (priv, entry);
+
+              if (weight < lowest_weight)
+                {
+                  lowest_weight = weight;
+                  lowest_key = key;
+                }
+            }
+
+          g_hash_table_remove (priv->match_history, lowest_key);
+        }
+
+      entry = g_new0 (MatchHistoryEntry, 1);
+      entry->weight = 1.0;
+      g_hash_table_insert (priv->match_history,
+                           fpi_print_copy_identity (match), entry);
+    }
+
+  entry->generation = priv->match_generation;
+}
+
+/* Judges a new enroll sample against the ones that were already accepted.
+ * Bozorth does not return an alignment, so the coverage is estimated from
+ * how novel the sample is: a score far above the threshold means that the
+ * finger was placed in the same position again. */
+static GError *
+fp_image_device_check_enroll_sample (FpImageDevice *self,
+                                     FpPrint       *enroll_print,
+                                     FpPrint       *print)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+  g_autoptr(GArray) scores = NULL;
+  g_autoptr(GError) error = NULL;
+  gint max_score = 0;
+  guint matched = 0;
+  gdouble consistency;
+  gdouble coverage;
+  guint i;
+
+  if (priv->enroll_stage == 0)
+    {
+      fpi_print_set_enroll_quality (print, 1.0, 1.0);
+      return NULL;
+    }
+
+  scores = fpi_print_bz3_scores (enroll_print, print, &error);
+  if (!scores || scores->len == 0)
+    {
+      if (error)
+        fp_warn ("Could not score enroll sample: %s", error->message);
+      return NULL;
+    }
+
+  for (i = 0; i < scores->len; i++)
+    {
+      gint score = g_array_index (scores, gint, i);
+
+      if (score >= priv->bz3_threshold)
+        matched++;
+      max_score = MAX (max_score, score);
+    }
+
+  consistency = (gdouble) matched / scores->len;
+  coverage = 1.0 - CLAMP ((gdouble) max_score /
+                          (priv->bz3_threshold * IMG_ENROLL_DUPLICATE_FACTOR),
+                          0.0, 1.0);
+  fpi_print_set_enroll_quality (print, consistency, coverage);
+
+  fp_dbg ("Enroll sample matches %u/%u samples, best score %d, coverage %.2f",
+          matched, scores->len, max_score, coverage);
+
+  /* Never accept a different finger, it would spoil the template */
+  if (matched == 0)
+    return fpi_device_retry_new_msg (FP_DEVICE_RETRY_GENERAL,
+                                     "Scan does not match earlier scans, please use the same finger");
+
+  /* A near duplicate is harmless, so stop insisting after a few attempts */
+  if (coverage == 0.0 && !priv->enroll_allow_duplicates)
+    {
+      priv->enroll_rejects += 1;
+      if (priv->enroll_rejects <= IMG_ENROLL_MAX_REJECTS)
+        return fpi_device_retry_new_msg (FP_DEVICE_RETRY_CENTER_FINGER,
+                                         "Scan is too similar to an earlier one, please move your finger slightly");
+
+      fp_info ("Accepting near duplicate enroll sample after %d rejected ones",
+               IMG_ENROLL_MAX_REJECTS);
+    }
+
+  priv->enroll_rejects = 0;
+  return NULL;
+}
+
+/* Adds a confidently matching scan to the template. Once the template is
+ * full, or if the scan is a near duplicate of a stored sample, the sample
+ * that is most similar to the scan is replaced, as the fresh scan covers
+ * the same area of the finger. */
+static void
+fp_image_device_adapt_template (FpImageDevice *self,
+                                FpPrint       *template,
+                                FpPrint       *print)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+  g_autoptr(GArray) scores = NULL;
+  g_autoptr(GError) error = NULL;
+  gint best_score = -1;
+  guint best = 0;
+  guint i;
+
+  if (!priv->adaptive_update)
+    return;
+
+  scores = fpi_print_bz3_scores (template, print, &error);
+  if (!scores)
+    {
+      fp_warn ("Could not score print for update: %s", error->message);
+      return;
+    }
+
+  for (i = 0; i < scores->len; i++)
+    {
+      gint score = g_array_index (scores, gint, i);
+
+      if (score > best_score)
+        {
+          best_score = score;
+          best = i;
+        }
+    }
+
+  if (best_score < priv->bz3_threshold * IMG_ADAPTIVE_UPDATE_FACTOR)
+    return;
+
+  if (scores->len < IMG_ADAPTIVE_MAX_SAMPLES &&
+      best_score < priv->bz3_threshold * IMG_ENROLL_DUPLICATE_FACTOR)
+    {
+      fp_dbg ("Adding scan with score %d to print", best_score);
+      fpi_print_add_print (template, print);
+    }
+  else
+    {
+      fp_dbg ("Replacing sample %u of print with scan, score %d", best, best_score);
+      fpi_print_replace_print (template, best, print);
+    }
+}
+
 static void
 fpi_image_device_minutiae_detected (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
@@ -258,12 +536,23 @@ fpi_image_device_minutiae_detected (GObject *source_object, GAsyncResult *res, g
         }
 
       /* Replace error with a retry condition. */
-      g_warning ("Failed to detect minutiae: %s", error->message);
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+        fp_info ("%s", error->message);
+      else
+        g_warning ("Failed to detect minutiae: %s", error->message);
       g_clear_pointer (&error, g_error_free);
 
       error = fpi_device_retry_new_msg (FP_DEVICE_RETRY_GENERAL, "Minutiae detection failed, please retry");
     }
 
+  if (!error)
+    {
+      fpi_device_metrics_observe (device, FPI_METRIC_EXTRACTION_US,
+                                  g_get_monotonic_time () - priv->minutiae_scan_start);
+      fpi_device_metrics_observe (device, FPI_METRIC_MINUTIAE,
+                                  fp_image_get_minutiae (image)->len);
+    }
+
   action = fpi_device_get_current_action (device);
 
   if (action == FPI_DEVICE_ACTION_CAPTURE)
@@ -296,6 +585,13 @@ fpi_image_device_minutiae_detected (GObject *source_object, GAsyncResult *res, g
       FpPrint *enroll_print;
       fpi_device_get_enroll_data (device, &enroll_print);
 
+      if (print)
+        {
+          error = fp_image_device_check_enroll_sample (self, enroll_print, print);
+          if (error)
+            g_clear_object (&print);
+        }
+
       if (print)
         {
           fpi_print_add_print (enroll_print, print);
@@ -323,9 +619,24 @@ fpi_image_device_minutiae_detected (GObject *source_object, GAsyncResult *res, g
 
       fpi_device_get_verify_data (device, &template);
       if (print)
-        result = fpi_print_bz3_match (template, print, priv->bz3_threshold, &error);
+        {
+          gint64 match_start = g_get_monotonic_time ();
+          gint score;
+
+          result = fpi_print_bz3_match (template, print, priv->bz3_threshold, &score, &error);
+          fpi_device_metrics_observe (device, FPI_METRIC_MATCH_US,
+                                      g_get_monotonic_time () - match_start);
+
+          if (result == FPI_MATCH_SUCCESS)
+            {
+              fpi_print_add_match_score (template, score);
+              fp_image_device_adapt_template (self, template, print);
+            }
+        }
       else
-        result = FPI_MATCH_ERROR;
+        {
+          result = FPI_MATCH_ERROR;
+        }
 
       if (!error || error->domain == FP_DEVICE_RETRY)
         fpi_device_verify_report (device, result, g_steal_pointer (&print), g_steal_pointer (&error));
@@ -336,20 +647,40 @@ fpi_image_device_minutiae_detected (GObject *source_object, GAsyncResult *res, g
     {
       gint i;
       GPtrArray *templates;
+      g_autoptr(GPtrArray) ordered = NULL;
       FpPrint *result = NULL;
+      gint64 match_start = g_get_monotonic_time ();
+      gint score = 0;
 
       fpi_device_get_identify_data (device, &templates);
-      for (i = 0; !error && i < templates->len; i++)
+      if (print)
+        ordered = fp_image_device_order_gallery (self, templates);
+
+      for (i = 0; ordered && !error && i < ordered->len; i++)
         {
-          FpPrint *template = g_ptr_array_index (templates, i);
+          FpPrint *template = g_ptr_array_index (ordered, i);
 
-          if (fpi_print_bz3_match (template, print, priv->bz3_threshold, &error) == FPI_MATCH_SUCCESS)
+          if (fpi_print_bz3_match (template, print, priv->bz3_threshold, &score, &error) == FPI_MATCH_SUCCESS)
             {
               result = template;
               break;
             }
         }
 
+      if (print)
+        {
+          fpi_device_metrics_observe (device, FPI_METRIC_MATCH_US,
+                                      g_get_monotonic_time () - match_start);
+          if (result)
+            {
+              fpi_print_add_match_score (result, score);
+              fp_image_device_adapt_template (self, result, print);
+            }
+          /* Record after updating, the history is keyed by the print data */
+          if (!error)
+            fp_image_device_record_match (self, result);
+        }
+
       if (!error || error->domain == FP_DEVICE_RETRY)
         fpi_device_identify_report (device, result, g_steal_pointer (&print), g_steal_pointer (&error));
 
@@ -389,7 +720,147 @@ fpi_image_device_set_bz3_threshold (FpImageDevice *self,
   g_return_if_fail (FP_IS_IMAGE_DEVICE (self));
   g_return_if_fail (bz3_threshold > 0);
 
-  priv->bz3_threshold = bz3_threshold;
+  priv->driver_bz3_threshold = bz3_threshold;
+  fpi_image_device_update_threshold (self);
+}
+
+/**
+ * fpi_image_device_set_enroll_allow_duplicates:
+ * @self: a #FpImageDevice imaging fingerprint device
+ * @allow: Whether to accept near duplicate enroll samples
+ *
+ * Overrides #FpImageDeviceClass.enroll_allow_duplicates for this device.
+ * Scans that do not match the earlier enroll samples are rejected in
+ * either case.
+ */
+void
+fpi_image_device_set_enroll_allow_duplicates (FpImageDevice *self,
+                                              gboolean       allow)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+
+  g_return_if_fail (FP_IS_IMAGE_DEVICE (self));
+
+  priv->enroll_allow_duplicates = allow;
+}
+
+/* Rough estimate of the impostor score distribution of bozorth3 for 500 DPI
+ * images of a full finger, not measured on any particular sensor. It puts
+ * the default threshold at a false accept rate of about 1 in 10000. */
+static const FpiScoreCalibration default_score_calibration[] = {
+  { 0, 1.0 },
+  { 10, 2e-1 },
+  { 20, 2e-2 },
+  { 30, 2e-3 },
+  { BOZORTH3_DEFAULT_THRESHOLD, 1e-4 },
+  { 50, 1e-5 },
+  { 60, 2e-6 },
+  { 80, 1e-7 },
+  { 0, 0.0 },
+};
+
+/* Bozorth3 scores of real prints stay well below this */
+#define MAX_BZ3_SCORE 10000
+
+/**
+ * fpi_image_device_score_to_far:
+ * @self: a #FpImageDevice imaging fingerprint device
+ * @score: A bozorth3 score
+ *
+ * Estimates how often a scan of a different finger reaches @score, based
+ * on the #FpiScoreCalibration table of the driver. Scores above the last
+ * entry of the table are mapped to its rate.
+ *
+ * Returns: The estimated false accept rate
+ */
+gdouble
+fpi_image_device_score_to_far (FpImageDevice *self,
+                               gint           score)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+  FpImageDeviceClass *cls = FP_IMAGE_DEVICE_GET_CLASS (self);
+  const FpiScoreCalibration *p = cls->score_calibration;
+  gdouble s = score;
+
+  g_return_val_if_fail (FP_IS_IMAGE_DEVICE (self), 1.0);
+
+  /* Drivers usually pick a lower threshold for small sensors, as fewer
+   * minutiae are found. Assume that it results in the same rate. */
+  if (!p)
+    {
+      p = default_score_calibration;
+      s = s * BOZORTH3_DEFAULT_THRESHOLD / priv->driver_bz3_threshold;
+    }
+
+  if (s <= p->score)
+    return p->far;
+
+  for (; p[1].far > 0; p++)
+    {
+      gdouble f;
+
+      if (s >= p[1].score)
+        continue;
+
+      f = (s - p->score) / (p[1].score - p->score);
+      return exp (log (p->far) + f * (log (p[1].far) - log (p->far)));
+    }
+
+  return p->far;
+}
+
+/**
+ * fpi_image_device_far_to_score:
+ * @self: a #FpImageDevice imaging fingerprint device
+ * @far: The false accept rate
+ *
+ * Finds the lowest bozorth3 score at which the estimated false accept rate
+ * does not exceed @far, see fpi_image_device_score_to_far().
+ *
+ * The table says nothing about scores above its last entry, so rates below
+ * the one of the last entry result in the score of the last entry.
+ *
+ * Returns: The threshold to use for @far
+ */
+gint
+fpi_image_device_far_to_score (FpImageDevice *self,
+                               gdouble        far)
+{
+  gdouble lowest_far;
+  gint score;
+
+  g_return_val_if_fail (FP_IS_IMAGE_DEVICE (self), BOZORTH3_DEFAULT_THRESHOLD);
+
+  lowest_far = fpi_image_device_score_to_far (self, MAX_BZ3_SCORE);
+  if (far < lowest_far)
+    {
+      fp_dbg ("False accept rate %g is below the calibrated range, using %g",
+              far, lowest_far);
+      far = lowest_far;
+    }
+
+  for (score = 1; score < MAX_BZ3_SCORE; score++)
+    if (fpi_image_device_score_to_far (self, score) <= far)
+      return score;
+
+  return MAX_BZ3_SCORE;
+}
+
+void
+fpi_image_device_update_threshold (FpImageDevice *self)
+{
+  FpImageDevicePrivate *priv = fp_image_device_get_instance_private (self);
+
+  if (priv->target_far > 0)
+    {
+      priv->bz3_threshold = fpi_image_device_far_to_score (self, priv->target_far);
+      fp_dbg ("Using threshold %d for a false accept rate of %g (driver default %d)",
+              priv->bz3_threshold, priv->target_far, priv->driver_bz3_threshold);
+    }
+  else
+    {
+      priv->bz3_threshold = priv->driver_bz3_threshold;
+    }
 }
 
 /**
@@ -493,13 +964,22 @@ fpi_image_device_image_captured (FpImageDevice *self, FpImage *image)
   g_debug ("Image device captured an image");
 
   priv->minutiae_scan_active = TRUE;
+  priv->minutiae_scan_start = g_get_monotonic_time ();
+
+  /* Keep the extraction buffers around for the lifetime of the device
+   * so that subsequent captures do not need to allocate them again. */
+  if (!priv->mindtct_workspace)
+    priv->mindtct_workspace = fpi_mindtct_workspace_new ();
 
   /* XXX: We also detect minutiae in capture mode, we solely do this
    *      to normalize the image which will happen as a by-product. */
-  fp_image_detect_minutiae (image,
-                            fpi_device_get_cancellable (FP_DEVICE (self)),
-                            fpi_image_device_minutiae_detected,
-                            self);
+  fpi_image_detect_minutiae_with_workspace (image,
+                                            priv->mindtct_workspace,
+                                            FP_IMAGE_DEVICE_GET_CLASS (self)->minutiae_profile,
+                                            fpi_device_get_cancellable (FP_DEVICE (self)),
+                                            priv->extraction_time_budget,
+                                            fpi_image_device_minutiae_detected,
+                                            self);
 
   /* XXX: This is wrong if we add support for raw capture mode. */
   fp_image_device_change_state (self, FPI_IMAGE_DEVICE_STATE_AWAIT_FINGER_OFF);
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "fpi-device.h"
+#include "fpi-image.h"
 #include "fp-image-device.h"
 
 /**
@@ -60,6 +61,26 @@
  *  - capture -> deactivating: deactivate vfunc is called
  *  - await-finger-off -> deactivating: deactivate vfunc is called
  */
+/**
+ * FpiScoreCalibration:
+ * @score: A bozorth3 score
+ * @far: Fraction of impostor comparisons that reach @score
+ *
+ * A point of the impostor score distribution of a driver, i.e. the rate
+ * at which scans of a different finger are falsely accepted if @score is
+ * used as the threshold. Tables of these are ordered by ascending score
+ * and terminated by an entry with a @far of 0. Values in between two
+ * points are interpolated logarithmically.
+ *
+ * The distribution should be measured offline using scans of many
+ * different fingers taken with the device.
+ */
+typedef struct
+{
+  gint    score;
+  gdouble far;
+} FpiScoreCalibration;
+
 typedef enum {
   FPI_IMAGE_DEVICE_STATE_INACTIVE,
   FPI_IMAGE_DEVICE_STATE_ACTIVATING,
@@ -75,6 +96,15 @@ typedef enum {
  * @bz3_threshold: Threshold to consider bozorth3 score a match, default: 40
  * @img_width: Width of the image, only provide if constant
  * @img_height: Height of the image, only provide if constant
+ * @score_calibration: (array zero-terminated=1): Estimated false accept
+ *   rates for bozorth3 scores, see #FpiScoreCalibration. If unset, a generic
+ *   estimate is used that is scaled so that @bz3_threshold has the same rate
+ *   as the default threshold.
+ * @enroll_allow_duplicates: Do not reject enroll samples that are near
+ *   duplicates of earlier ones, e.g. for devices that always return the
+ *   same image
+ * @minutiae_profile: Parameters for the minutiae extraction, see
+ *   #FpiMinutiaeProfile. If unset, the mindtct defaults are used.
  * @img_open: Open the device and do basic initialization
  *   (use this instead of the #FpDeviceClass open vfunc)
  * @img_close: Close the device
@@ -108,6 +138,12 @@ struct _FpImageDeviceClass
   gint          img_width;
   gint          img_height;
 
+  const FpiScoreCalibration *score_calibration;
+
+  gboolean      enroll_allow_duplicates;
+
+  const FpiMinutiaeProfile *minutiae_profile;
+
   void          (*img_open)     (FpImageDevice *dev);
   void          (*img_close)    (FpImageDevice *dev);
   void          (*activate)     (FpImageDevice *dev);
@@ -118,6 +154,13 @@ struct _FpImageDeviceClass
 
 void fpi_image_device_set_bz3_threshold (FpImageDevice *self,
                                          gint           bz3_threshold);
+void fpi_image_device_set_enroll_allow_duplicates (FpImageDevice *self,
+                                                   gboolean       allow);
+
+gdouble fpi_image_device_score_to_far (FpImageDevice *self,
+                                       gint           score);
+gint    fpi_image_device_far_to_score (FpImageDevice *self,
+                                       gdouble        far);
 
 void fpi_image_device_session_error (FpImageDevice *self,
                                      GError        *error);
@@ -152,3 +152,54 @@ fpi_image_resize (FpImage *orig_img,
   return g_object_ref (orig_img);
 #endif
 }
+
+/**
+ * fpi_minutiae_profile_to_lfsparms:
+ * @profile: (nullable): A #FpiMinutiaeProfile, or %NULL for the defaults
+ * @lfsparms: (out caller-allocates): The mindtct parameters to initialize
+ *
+ * Initializes @lfsparms with the mindtct V2 defaults and applies the
+ * fields of @profile that are set. The parameters that depend on the
+ * block size are derived in the same way as for the defaults.
+ *
+ * Returns: %FALSE if @profile is invalid, @lfsparms has the defaults then
+ */
+gboolean
+fpi_minutiae_profile_to_lfsparms (const FpiMinutiaeProfile *profile,
+                                  struct g_lfsparms        *lfsparms)
+{
+  gint blocksize;
+  gint windowsize;
+
+  *lfsparms = g_lfsparms_V2;
+
+  if (!profile)
+    return TRUE;
+
+  blocksize = profile->blocksize;
+  windowsize = profile->windowsize;
+
+  if (blocksize <= 0)
+    blocksize = lfsparms->blocksize;
+  if (windowsize <= 0)
+    windowsize = blocksize + 2 * lfsparms->windowoffset;
+
+  if (windowsize < blocksize || (windowsize - blocksize) % 2 != 0)
+    {
+      g_warning ("Invalid minutiae profile, window size %d for block size %d",
+                 windowsize, blocksize);
+      return FALSE;
+    }
+
+  /* Same relations as between the mindtct V2 defaults */
+  lfsparms->blocksize = blocksize;
+  lfsparms->windowsize = windowsize;
+  lfsparms->windowoffset = (windowsize - blocksize) / 2;
+  lfsparms->trans_dir_pix = blocksize / 2;
+  lfsparms->inv_block_margin = blocksize / 2;
+
+  if (profile->num_dft_waves > 0)
+    lfsparms->num_dft_waves = CLAMP (profile->num_dft_waves, 2, NUM_DFT_WAVES);
+
+  return TRUE;
+}
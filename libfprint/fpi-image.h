@@ -79,3 +79,60 @@ gint fpi_mean_sq_diff_norm (const guint8 *buf1,
 FpImage *fpi_image_resize (FpImage *orig,
                            guint    w_factor,
                            guint    h_factor);
+
+/**
+ * FpiMinutiaeProfile:
+ * @blocksize: Size in pixels of the blocks that the ridge flow is
+ *   estimated for, 8 by default
+ * @windowsize: Size in pixels of the window around each block that is
+ *   analysed, 24 by default. Needs to exceed @blocksize by an even number.
+ * @num_dft_waves: Number of ridge frequencies that are tested, from 2
+ *   to 4, 4 by default
+ *
+ * Parameters for the minutiae extraction that differ from the defaults,
+ * which are tuned for 500 PPI images of a whole finger. Fields set to 0
+ * keep the default. The remaining block related parameters are derived
+ * in the same way as for the defaults.
+ *
+ * The profile is used as is, it is not adjusted to the resolution of
+ * the image. The extraction time grows with the number of blocks,
+ * @windowsize and @num_dft_waves.
+ *
+ * A profile should be tuned against captures of the device. Changing it
+ * changes the minutiae of new scans, so prints that were enrolled before
+ * may match worse.
+ */
+typedef struct
+{
+  gint blocksize;
+  gint windowsize;
+  gint num_dft_waves;
+} FpiMinutiaeProfile;
+
+struct g_lfsparms;
+
+gboolean fpi_minutiae_profile_to_lfsparms (const FpiMinutiaeProfile *profile,
+                                           struct g_lfsparms        *lfsparms);
+
+/**
+ * FpiMindtctWorkspace:
+ *
+ * Opaque working memory for minutiae extraction. Keeping one around
+ * between detections means lookup tables and buffers are only allocated
+ * again if the image dimensions change.
+ */
+typedef struct _FpiMindtctWorkspace FpiMindtctWorkspace;
+
+FpiMindtctWorkspace *fpi_mindtct_workspace_new (void);
+FpiMindtctWorkspace *fpi_mindtct_workspace_ref (FpiMindtctWorkspace *workspace);
+void                 fpi_mindtct_workspace_unref (FpiMindtctWorkspace *workspace);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (FpiMindtctWorkspace, fpi_mindtct_workspace_unref)
+
+void fpi_image_detect_minutiae_with_workspace (FpImage                  *self,
+                                               FpiMindtctWorkspace      *workspace,
+                                               const FpiMinutiaeProfile *profile,
+                                               GCancellable             *cancellable,
+                                               guint                     time_budget_ms,
+                                               GAsyncReadyCallback       callback,
+                                               gpointer                  user_data);
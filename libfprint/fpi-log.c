@@ -0,0 +1,61 @@
+/*
+ * FPrint logging helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "fpi-log.h"
+
+#include <string.h>
+
+/**
+ * fpi_log_debug_enabled:
+ * @log_domain: The log domain to check
+ *
+ * Checks whether GLib's default log writer would print debug messages for
+ * @log_domain, following the same rules for `G_MESSAGES_DEBUG`.
+ *
+ * This does not cache the result, use fp_dbg() which does so for every call
+ * site.
+ *
+ * Returns: %TRUE if debug messages for @log_domain are shown
+ */
+gboolean
+fpi_log_debug_enabled (const char *log_domain)
+{
+  const char *domains = g_getenv ("G_MESSAGES_DEBUG");
+  const char *found;
+  gsize len;
+
+  if (domains == NULL)
+    return FALSE;
+
+  if (strcmp (domains, "all") == 0)
+    return TRUE;
+
+  if (log_domain == NULL)
+    return FALSE;
+
+  /* Only accept whole words, separated by spaces or commas */
+  len = strlen (log_domain);
+  for (found = strstr (domains, log_domain); found; found = strstr (found + 1, log_domain))
+    {
+      if ((found == domains || found[-1] == ' ' || found[-1] == ',') &&
+          (found[len] == '\0' || found[len] == ' ' || found[len] == ','))
+        return TRUE;
+    }
+
+  return FALSE;
+}
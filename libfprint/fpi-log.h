@@ -42,20 +42,57 @@
 
 #include <glib.h>
 
+gboolean fpi_log_debug_enabled (const char *log_domain);
+
+#ifndef __GTK_DOC_IGNORE__
+#ifndef FP_DISABLE_DEBUG_LOG
+/* The result of the domain check is cached for each call site, so that
+ * disabled messages only cost a single load and the arguments are never
+ * evaluated. */
+#define FPI_LOG_DEBUG_GUARDED(...) G_STMT_START {                        \
+    static gint _fpi_log_cached = 0;                                      \
+    gint _fpi_log_state = g_atomic_int_get (&_fpi_log_cached);            \
+    if (G_UNLIKELY (_fpi_log_state == 0))                                 \
+      {                                                                   \
+        _fpi_log_state = fpi_log_debug_enabled (G_LOG_DOMAIN) ? 2 : 1;    \
+        g_atomic_int_set (&_fpi_log_cached, _fpi_log_state);              \
+      }                                                                   \
+    if (_fpi_log_state == 2)                                              \
+      g_debug (__VA_ARGS__);                                              \
+  } G_STMT_END
+#else
+/* Keep the compiler checking the format and arguments */
+#define FPI_LOG_DEBUG_GUARDED(...) G_STMT_START {                        \
+    if (0)                                                                \
+      g_debug (__VA_ARGS__);                                              \
+  } G_STMT_END
+#endif
+#endif
+
 /**
  * fp_dbg:
  *
- * Same as g_debug().
+ * Same as g_debug(), except that the arguments are only evaluated if
+ * debug output is enabled for the log domain through `G_MESSAGES_DEBUG`.
+ *
+ * The environment is only checked the first time a message is hit, and the
+ * result is cached for that call site. Changing `G_MESSAGES_DEBUG` later on
+ * has no effect on call sites that already ran. Messages that were disabled
+ * this way are also never passed to a custom handler or writer set with
+ * g_log_set_handler() or g_log_set_writer_func(), even if it would print
+ * debug messages regardless of `G_MESSAGES_DEBUG`.
  *
+ * When building with the `debug_log` option disabled, the message is
+ * removed entirely.
  */
-#define fp_dbg g_debug
+#define fp_dbg(...) FPI_LOG_DEBUG_GUARDED (__VA_ARGS__)
 
 /**
  * fp_info:
  *
- * Same as g_debug().
+ * Same as fp_dbg().
  */
-#define fp_info g_debug
+#define fp_info(...) FPI_LOG_DEBUG_GUARDED (__VA_ARGS__)
 
 /**
  * fp_warn:
@@ -0,0 +1,260 @@
+/*
+ * FPrint device metrics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "fpi-metrics.h"
+#include "fp-device-private.h"
+
+/**
+ * SECTION:fpi-metrics
+ * @title: Device metrics
+ * @short_description: Counters and histograms about device usage
+ *
+ * Every device keeps a set of counters and histograms, e.g. about scans,
+ * match results, USB traffic and processing times. The core updates most
+ * of them, drivers only need to report additional information where the
+ * core cannot know about it.
+ *
+ * The values can be retrieved by API users using fp_context_get_metrics().
+ */
+
+typedef struct
+{
+  const char *name;
+  const char *label;
+  const char *label_value;
+} CounterInfo;
+
+static const CounterInfo counter_info[FPI_METRIC_N_COUNTERS] = {
+  [FPI_METRIC_SCANS] = { "fprint_scans_total", NULL, NULL },
+  [FPI_METRIC_MATCHES] = { "fprint_match_results_total", "result", "match" },
+  [FPI_METRIC_NO_MATCHES] = { "fprint_match_results_total", "result", "no-match" },
+  [FPI_METRIC_USB_BYTES_IN] = { "fprint_usb_bytes_total", "direction", "in" },
+  [FPI_METRIC_USB_BYTES_OUT] = { "fprint_usb_bytes_total", "direction", "out" },
+  [FPI_METRIC_USB_TRANSFER_ERRORS] = { "fprint_usb_transfer_errors_total", NULL, NULL },
+};
+
+typedef struct
+{
+  const char *name;
+  gdouble     scale;
+} HistogramInfo;
+
+/* Times are recorded in microseconds but exported in seconds */
+static const HistogramInfo histogram_info[FPI_METRIC_N_HISTOGRAMS] = {
+  [FPI_METRIC_MINUTIAE] = { "fprint_minutiae", 1.0 },
+  [FPI_METRIC_EXTRACTION_US] = { "fprint_extraction_seconds", 1e-6 },
+  [FPI_METRIC_MATCH_US] = { "fprint_match_seconds", 1e-6 },
+};
+
+static FpiMetrics *
+get_metrics (FpDevice *device)
+{
+  FpDevicePrivate *priv = fp_device_get_instance_private (device);
+
+  return &priv->metrics;
+}
+
+/**
+ * fpi_device_metrics_add:
+ * @device: The #FpDevice
+ * @counter: The #FpiMetricCounter to increase
+ * @value: The value to add
+ *
+ * Increases a counter of the device.
+ */
+void
+fpi_device_metrics_add (FpDevice        *device,
+                        FpiMetricCounter counter,
+                        guint64          value)
+{
+  g_return_if_fail (FP_IS_DEVICE (device));
+  g_return_if_fail (counter < FPI_METRIC_N_COUNTERS);
+
+  get_metrics (device)->counters[counter] += value;
+}
+
+/**
+ * fpi_device_metrics_observe:
+ * @device: The #FpDevice
+ * @histogram: The #FpiMetricHistogram to record into
+ * @value: The observed value
+ *
+ * Records a value in a histogram of the device.
+ */
+void
+fpi_device_metrics_observe (FpDevice          *device,
+                            FpiMetricHistogram histogram,
+                            guint64            value)
+{
+  FpiMetricsHistogram *h;
+  guint bucket = 0;
+
+  g_return_if_fail (FP_IS_DEVICE (device));
+  g_return_if_fail (histogram < FPI_METRIC_N_HISTOGRAMS);
+
+  h = &get_metrics (device)->histograms[histogram];
+
+  /* Bucket i holds values up to 2^i */
+  while (bucket < FPI_METRICS_HISTOGRAM_BUCKETS - 1 &&
+         value > (G_GUINT64_CONSTANT (1) << bucket))
+    bucket++;
+
+  h->buckets[bucket]++;
+  h->count++;
+  h->sum += value;
+}
+
+/**
+ * fpi_device_metrics_retry:
+ * @device: The #FpDevice
+ * @reason: The #FpDeviceRetry reason
+ *
+ * Counts a scan that needs to be retried.
+ */
+void
+fpi_device_metrics_retry (FpDevice     *device,
+                          FpDeviceRetry reason)
+{
+  g_return_if_fail (FP_IS_DEVICE (device));
+
+  if (reason >= FPI_METRICS_N_RETRY_REASONS)
+    reason = FP_DEVICE_RETRY_GENERAL;
+
+  get_metrics (device)->retries[reason]++;
+}
+
+/**
+ * fpi_device_metrics_temperature:
+ * @device: The #FpDevice
+ * @temperature: The new #FpTemperature
+ *
+ * Counts a change of the device temperature.
+ */
+void
+fpi_device_metrics_temperature (FpDevice     *device,
+                                FpTemperature temperature)
+{
+  g_return_if_fail (FP_IS_DEVICE (device));
+  g_return_if_fail (temperature < FPI_METRICS_N_TEMPERATURES);
+
+  get_metrics (device)->temperatures[temperature]++;
+}
+
+static void
+add_sample (GVariantBuilder *builder,
+            const char      *name,
+            const char      *driver,
+            const char      *device_id,
+            const char      *label,
+            const char      *label_value,
+            gdouble          value)
+{
+  GVariantBuilder labels;
+
+  g_variant_builder_init (&labels, G_VARIANT_TYPE ("a{ss}"));
+  g_variant_builder_add (&labels, "{ss}", "driver", driver);
+  g_variant_builder_add (&labels, "{ss}", "device", device_id ? device_id : "");
+  if (label)
+    g_variant_builder_add (&labels, "{ss}", label, label_value);
+
+  g_variant_builder_add (builder, "(sa{ss}d)", name, &labels, value);
+}
+
+static void
+add_enum_samples (GVariantBuilder *builder,
+                  const char      *name,
+                  const char      *driver,
+                  const char      *device_id,
+                  GType            enum_type,
+                  const char      *label,
+                  const guint64   *values,
+                  guint            n_values)
+{
+  g_autoptr(GEnumClass) enum_class = g_type_class_ref (enum_type);
+  guint i;
+
+  for (i = 0; i < n_values; i++)
+    {
+      GEnumValue *value = g_enum_get_value (enum_class, i);
+
+      add_sample (builder, name, driver, device_id,
+                  label, value ? value->value_nick : "unknown",
+                  values[i]);
+    }
+}
+
+/**
+ * fpi_device_metrics_append_samples:
+ * @device: The #FpDevice
+ * @builder: A #GVariantBuilder for an array of samples
+ *
+ * Adds all values of @device as samples of type (sa{ss}d) to @builder.
+ * Histograms are split into cumulative buckets, a sum and a count, as
+ * Prometheus does.
+ */
+void
+fpi_device_metrics_append_samples (FpDevice        *device,
+                                   GVariantBuilder *builder)
+{
+  const FpiMetrics *metrics;
+  const char *driver;
+  const char *device_id;
+  guint i, j;
+
+  g_return_if_fail (FP_IS_DEVICE (device));
+
+  metrics = get_metrics (device);
+  driver = fp_device_get_driver (device);
+  device_id = fp_device_get_device_id (device);
+
+  for (i = 0; i < FPI_METRIC_N_COUNTERS; i++)
+    add_sample (builder, counter_info[i].name, driver, device_id,
+                counter_info[i].label, counter_info[i].label_value,
+                metrics->counters[i]);
+
+  add_enum_samples (builder, "fprint_retries_total", driver, device_id,
+                    FP_TYPE_DEVICE_RETRY, "reason",
+                    metrics->retries, FPI_METRICS_N_RETRY_REASONS);
+  add_enum_samples (builder, "fprint_temperature_changes_total", driver, device_id,
+                    FP_TYPE_TEMPERATURE, "temperature",
+                    metrics->temperatures, FPI_METRICS_N_TEMPERATURES);
+
+  for (i = 0; i < FPI_METRIC_N_HISTOGRAMS; i++)
+    {
+      const FpiMetricsHistogram *h = &metrics->histograms[i];
+      g_autofree char *bucket_name = g_strconcat (histogram_info[i].name, "_bucket", NULL);
+      g_autofree char *sum_name = g_strconcat (histogram_info[i].name, "_sum", NULL);
+      g_autofree char *count_name = g_strconcat (histogram_info[i].name, "_count", NULL);
+      guint64 cumulative = 0;
+
+      for (j = 0; j < FPI_METRICS_HISTOGRAM_BUCKETS - 1; j++)
+        {
+          char le[G_ASCII_DTOSTR_BUF_SIZE];
+
+          cumulative += h->buckets[j];
+          g_ascii_dtostr (le, sizeof (le),
+                          (G_GUINT64_CONSTANT (1) << j) * histogram_info[i].scale);
+          add_sample (builder, bucket_name, driver, device_id, "le", le, cumulative);
+        }
+
+      add_sample (builder, bucket_name, driver, device_id, "le", "+Inf", h->count);
+      add_sample (builder, sum_name, driver, device_id, NULL, NULL,
+                  h->sum * histogram_info[i].scale);
+      add_sample (builder, count_name, driver, device_id, NULL, NULL, h->count);
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * FPrint device metrics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+
+#include "fp-device.h"
+
+G_BEGIN_DECLS
+
+/**
+ * FpiMetricCounter:
+ * @FPI_METRIC_SCANS: Number of finger scans reported by the driver
+ * @FPI_METRIC_MATCHES: Number of scans that matched a print
+ * @FPI_METRIC_NO_MATCHES: Number of scans that did not match any print
+ * @FPI_METRIC_USB_BYTES_IN: Bytes received from the device
+ * @FPI_METRIC_USB_BYTES_OUT: Bytes sent to the device
+ * @FPI_METRIC_USB_TRANSFER_ERRORS: Failed USB transfers, not counting
+ *   cancellations
+ * @FPI_METRIC_N_COUNTERS: Number of counters
+ *
+ * Simple counters kept for each device. Retries and temperature changes
+ * are counted separately, see fpi_device_metrics_retry() and
+ * fpi_device_metrics_temperature().
+ */
+typedef enum {
+  FPI_METRIC_SCANS,
+  FPI_METRIC_MATCHES,
+  FPI_METRIC_NO_MATCHES,
+  FPI_METRIC_USB_BYTES_IN,
+  FPI_METRIC_USB_BYTES_OUT,
+  FPI_METRIC_USB_TRANSFER_ERRORS,
+  FPI_METRIC_N_COUNTERS,
+} FpiMetricCounter;
+
+/**
+ * FpiMetricHistogram:
+ * @FPI_METRIC_MINUTIAE: Number of minutiae found in an image
+ * @FPI_METRIC_EXTRACTION_US: Time to extract the minutiae in microseconds
+ * @FPI_METRIC_MATCH_US: Time to match a scan against the prints in
+ *   microseconds
+ * @FPI_METRIC_N_HISTOGRAMS: Number of histograms
+ *
+ * Histograms kept for each device, using power of two buckets.
+ */
+typedef enum {
+  FPI_METRIC_MINUTIAE,
+  FPI_METRIC_EXTRACTION_US,
+  FPI_METRIC_MATCH_US,
+  FPI_METRIC_N_HISTOGRAMS,
+} FpiMetricHistogram;
+
+#define FPI_METRICS_HISTOGRAM_BUCKETS 24
+#define FPI_METRICS_N_RETRY_REASONS (FP_DEVICE_RETRY_REMOVE_FINGER + 1)
+#define FPI_METRICS_N_TEMPERATURES (FP_TEMPERATURE_HOT + 1)
+
+typedef struct
+{
+  guint64 buckets[FPI_METRICS_HISTOGRAM_BUCKETS];
+  guint64 count;
+  guint64 sum;
+} FpiMetricsHistogram;
+
+/* Only ever modified from the thread that runs the device, so that no
+ * locking or atomic operations are needed. */
+typedef struct
+{
+  guint64             counters[FPI_METRIC_N_COUNTERS];
+  guint64             retries[FPI_METRICS_N_RETRY_REASONS];
+  guint64             temperatures[FPI_METRICS_N_TEMPERATURES];
+  FpiMetricsHistogram histograms[FPI_METRIC_N_HISTOGRAMS];
+} FpiMetrics;
+
+void fpi_device_metrics_add (FpDevice        *device,
+                             FpiMetricCounter counter,
+                             guint64          value);
+void fpi_device_metrics_observe (FpDevice          *device,
+                                 FpiMetricHistogram histogram,
+                                 guint64            value);
+void fpi_device_metrics_retry (FpDevice     *device,
+                               FpDeviceRetry reason);
+void fpi_device_metrics_temperature (FpDevice     *device,
+                                     FpTemperature temperature);
+
+void fpi_device_metrics_append_samples (FpDevice        *device,
+                                        GVariantBuilder *builder);
+
+G_END_DECLS
@@ -25,6 +25,9 @@
 #include "fpi-device.h"
 #include "fpi-compat.h"
 
+/* Number of recent scores that dominate fp_print_get_score_mean() */
+#define FPI_PRINT_SCORE_MEAN_WINDOW 16
+
 /**
  * SECTION: fpi-print
  * @title: Internal FpPrint
@@ -53,6 +56,27 @@ fpi_print_add_print (FpPrint *print, FpPrint *add)
   g_ptr_array_add (print->prints, g_memdup2 (add->prints->pdata[0], sizeof (struct xyt_struct)));
 }
 
+/**
+ * fpi_print_replace_print:
+ * @print: A #FpPrint
+ * @index: Index of the print in @print to replace
+ * @add: Print to store instead
+ *
+ * Like fpi_print_add_print(), but replaces the existing print at @index
+ * rather than growing the collection.
+ */
+void
+fpi_print_replace_print (FpPrint *print, guint index, FpPrint *add)
+{
+  g_return_if_fail (print->type == FPI_PRINT_NBIS);
+  g_return_if_fail (add->type == FPI_PRINT_NBIS);
+  g_return_if_fail (index < print->prints->len);
+
+  g_assert (add->prints->len == 1);
+  g_free (print->prints->pdata[index]);
+  print->prints->pdata[index] = g_memdup2 (add->prints->pdata[0], sizeof (struct xyt_struct));
+}
+
 /**
  * fpi_print_set_type:
  * @print: A #FpPrint
@@ -97,6 +121,78 @@ fpi_print_set_device_stored (FpPrint *print,
   g_object_notify (G_OBJECT (print), "device-stored");
 }
 
+/**
+ * fpi_print_set_enroll_quality:
+ * @print: A #FpPrint
+ * @consistency: Fraction of earlier samples that match, from 0.0 to 1.0
+ * @coverage: How much new area the sample adds, from 0.0 to 1.0
+ *
+ * Attaches the quality of a new enroll sample before it is passed to
+ * fpi_device_enroll_progress(), see fp_print_get_enroll_quality().
+ */
+void
+fpi_print_set_enroll_quality (FpPrint *print,
+                              gdouble  consistency,
+                              gdouble  coverage)
+{
+  g_return_if_fail (FP_IS_PRINT (print));
+
+  print->has_enroll_quality = TRUE;
+  print->enroll_consistency = CLAMP (consistency, 0.0, 1.0);
+  print->enroll_coverage = CLAMP (coverage, 0.0, 1.0);
+}
+
+/**
+ * fpi_print_record_match:
+ * @print: A #FpPrint that a scan was compared against
+ * @matched: Whether the scan matched @print
+ *
+ * Updates the usage statistics of @print, see fp_print_get_match_count().
+ * This is done by the core when a verify or identify result is reported,
+ * drivers do not need to call it.
+ */
+void
+fpi_print_record_match (FpPrint *print,
+                        gboolean matched)
+{
+  g_return_if_fail (FP_IS_PRINT (print));
+
+  if (!matched)
+    {
+      if (print->no_match_count < G_MAXUINT)
+        print->no_match_count++;
+      return;
+    }
+
+  if (print->match_count < G_MAXUINT)
+    print->match_count++;
+
+  g_clear_pointer (&print->last_match, g_date_time_unref);
+  print->last_match = g_date_time_new_now_utc ();
+}
+
+/**
+ * fpi_print_add_match_score:
+ * @print: A #FpPrint that matched a scan
+ * @score: The driver specific match score
+ *
+ * Adds @score to the rolling mean returned by fp_print_get_score_mean().
+ * Drivers that know the score of a match should call this before
+ * reporting the result.
+ */
+void
+fpi_print_add_match_score (FpPrint *print,
+                           gint     score)
+{
+  g_return_if_fail (FP_IS_PRINT (print));
+
+  /* Plain mean over the first scores, then an exponential moving average */
+  if (print->score_count < FPI_PRINT_SCORE_MEAN_WINDOW)
+    print->score_count++;
+
+  print->score_mean += (score - print->score_mean) / print->score_count;
+}
+
 /* XXX: This is the old version, but wouldn't it be smarter to instead
  * use the highest quality mintutiae? Possibly just using bz_prune from
  * upstream? */
@@ -199,6 +295,8 @@ fpi_print_add_from_image (FpPrint *print,
  * @template: A #FpPrint containing one or more prints
  * @print: A newly scanned #FpPrint to test
  * @bz3_threshold: The BZ3 match threshold
+ * @score: (out) (optional): Return location for the score of the matching
+ *   print, or the best score if there is no match
  * @error: Return location for error
  *
  * Match the newly scanned @print (containing exactly one print) against the
@@ -210,7 +308,8 @@ fpi_print_add_from_image (FpPrint *print,
  * Returns: Whether the prints match, @error will be set if #FPI_MATCH_ERROR is returned
  */
 FpiMatchResult
-fpi_print_bz3_match (FpPrint *template, FpPrint *print, gint bz3_threshold, GError **error)
+fpi_print_bz3_match (FpPrint *template, FpPrint *print, gint bz3_threshold,
+                     gint *score, GError **error)
 {
   struct xyt_struct *pstruct;
   gint probe_len;
@@ -234,21 +333,174 @@ fpi_print_bz3_match (FpPrint *template, FpPrint *print, gint bz3_threshold, GErr
   pstruct = g_ptr_array_index (print->prints, 0);
   probe_len = bozorth_probe_init (pstruct);
 
+  if (score)
+    *score = 0;
+
   for (i = 0; i < template->prints->len; i++)
     {
       struct xyt_struct *gstruct;
-      gint score;
+      gint s;
       gstruct = g_ptr_array_index (template->prints, i);
-      score = bozorth_to_gallery (probe_len, pstruct, gstruct);
-      fp_dbg ("score %d/%d", score, bz3_threshold);
-
-      if (score >= bz3_threshold)
-        return FPI_MATCH_SUCCESS;
+      s = bozorth_to_gallery (probe_len, pstruct, gstruct);
+      fp_dbg ("score %d/%d", s, bz3_threshold);
+
+      if (score)
+        *score = MAX (*score, s);
+
+      if (s >= bz3_threshold)
+        {
+          if (score)
+            *score = s;
+          return FPI_MATCH_SUCCESS;
+        }
     }
 
   return FPI_MATCH_FAIL;
 }
 
+/**
+ * fpi_print_bz3_scores:
+ * @template: A #FpPrint containing one or more prints
+ * @print: A newly scanned #FpPrint containing exactly one print
+ * @error: Return location for error
+ *
+ * Like fpi_print_bz3_match(), but compares @print against all prints in
+ * @template and returns the individual scores. This is useful to judge
+ * new samples during enrollment.
+ *
+ * Returns: (transfer full): A #GArray of #gint scores, one for each print
+ *   in @template, or %NULL on error
+ */
+GArray *
+fpi_print_bz3_scores (FpPrint *template, FpPrint *print, GError **error)
+{
+  struct xyt_struct *pstruct;
+  GArray *scores;
+  gint probe_len;
+  gint i;
+
+  if (template->type != FPI_PRINT_NBIS || print->type != FPI_PRINT_NBIS)
+    {
+      g_set_error_literal (error, FP_DEVICE_ERROR, FP_DEVICE_ERROR_NOT_SUPPORTED,
+                           "It is only possible to match NBIS type print data");
+      return NULL;
+    }
+
+  if (print->prints->len != 1)
+    {
+      g_set_error_literal (error, FP_DEVICE_ERROR, FP_DEVICE_ERROR_GENERAL,
+                           "New print contains more than one print!");
+      return NULL;
+    }
+
+  pstruct = g_ptr_array_index (print->prints, 0);
+  probe_len = bozorth_probe_init (pstruct);
+
+  scores = g_array_sized_new (FALSE, FALSE, sizeof (gint), template->prints->len);
+  for (i = 0; i < template->prints->len; i++)
+    {
+      struct xyt_struct *gstruct = g_ptr_array_index (template->prints, i);
+      gint score = bozorth_to_gallery (probe_len, pstruct, gstruct);
+
+      g_array_append_val (scores, score);
+    }
+
+  return scores;
+}
+
+/**
+ * fpi_print_hash:
+ * @print: A #FpPrint
+ *
+ * Calculates a hash over the identity and data of @print. Prints that are
+ * considered equal by fp_print_equal() have the same hash, so it can be
+ * used to recognize the same print in separate #FpPrint instances, e.g.
+ * when a gallery is loaded from disk again for every identification.
+ *
+ * Returns: The hash value
+ */
+guint
+fpi_print_hash (FpPrint *print)
+{
+  guint hash;
+
+  g_return_val_if_fail (FP_IS_PRINT (print), 0);
+
+  hash = g_str_hash (print->driver ? print->driver : "");
+  hash = hash * 31 + g_str_hash (print->device_id ? print->device_id : "");
+  hash = hash * 31 + print->type;
+
+  if (print->type == FPI_PRINT_RAW && print->data)
+    {
+      g_autoptr(GBytes) bytes = g_variant_get_data_as_bytes (print->data);
+
+      hash = hash * 31 + g_bytes_hash (bytes);
+    }
+  else if (print->type == FPI_PRINT_NBIS && print->prints)
+    {
+      guint i;
+      gint j;
+
+      /* Hashing the rows that are in use is sufficient */
+      for (i = 0; i < print->prints->len; i++)
+        {
+          struct xyt_struct *xyt = g_ptr_array_index (print->prints, i);
+
+          hash = hash * 31 + xyt->nrows;
+          for (j = 0; j < xyt->nrows; j++)
+            {
+              hash = hash * 31 + xyt->xcol[j];
+              hash = hash * 31 + xyt->ycol[j];
+              hash = hash * 31 + xyt->thetacol[j];
+            }
+        }
+    }
+
+  return hash;
+}
+
+/**
+ * fpi_print_copy_identity:
+ * @print: A #FpPrint
+ *
+ * Creates a new print with a copy of the driver, device ID and data of
+ * @print, which is everything that fp_print_equal() and fpi_print_hash()
+ * look at. The metadata is not copied. Unlike @print itself, the copy is
+ * not modified by template updates, so it can be used as a hash table key.
+ *
+ * Returns: (transfer full): A new #FpPrint
+ */
+FpPrint *
+fpi_print_copy_identity (FpPrint *print)
+{
+  FpPrint *copy;
+  guint i;
+
+  g_return_val_if_fail (FP_IS_PRINT (print), NULL);
+
+  copy = g_object_new (FP_TYPE_PRINT,
+                       "driver", print->driver,
+                       "device-id", print->device_id,
+                       NULL);
+  g_object_ref_sink (copy);
+
+  if (print->type == FPI_PRINT_UNDEFINED)
+    return copy;
+
+  fpi_print_set_type (copy, print->type);
+
+  if (print->data)
+    copy->data = g_variant_ref (print->data);
+
+  if (print->type == FPI_PRINT_NBIS)
+    for (i = 0; i < print->prints->len; i++)
+      g_ptr_array_add (copy->prints,
+                       g_memdup2 (g_ptr_array_index (print->prints, i),
+                                  sizeof (struct xyt_struct)));
+
+  return copy;
+}
+
 /**
  * fpi_print_generate_user_id:
  * @print: #FpPrint to generate the ID for
@@ -32,6 +32,9 @@ typedef enum {
 
 void     fpi_print_add_print (FpPrint *print,
                               FpPrint *add);
+void     fpi_print_replace_print (FpPrint *print,
+                                  guint    index,
+                                  FpPrint *add);
 
 void     fpi_print_set_type (FpPrint     *print,
                              FpiPrintType type);
@@ -45,8 +48,25 @@ gboolean fpi_print_add_from_image (FpPrint *print,
 FpiMatchResult fpi_print_bz3_match (FpPrint *temp,
                                     FpPrint *print,
                                     gint     bz3_threshold,
+                                    gint    *score,
                                     GError **error);
 
+GArray * fpi_print_bz3_scores (FpPrint *temp,
+                               FpPrint *print,
+                               GError **error);
+
+void     fpi_print_set_enroll_quality (FpPrint *print,
+                                       gdouble  consistency,
+                                       gdouble  coverage);
+
+void     fpi_print_record_match (FpPrint *print,
+                                 gboolean matched);
+void     fpi_print_add_match_score (FpPrint *print,
+                                    gint     score);
+
+guint    fpi_print_hash (FpPrint *print);
+FpPrint *fpi_print_copy_identity (FpPrint *print);
+
 /* Helpers to encode metadata into user ID strings. */
 gchar *  fpi_print_generate_user_id (FpPrint *print);
 gboolean fpi_print_fill_from_user_id (FpPrint    *print,
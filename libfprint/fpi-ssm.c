@@ -68,8 +68,20 @@
  * communication with the device (such as a USB transfer), and the
  * callback function iterates the machine to the next state
  * upon success (or fails).
+ *
+ * For latency analysis, the time spent in each state, the number of delayed
+ * transitions and the total run time of each machine can be recorded. This
+ * is enabled by setting FP_DEBUG_SSM_STATS in the environment or by calling
+ * fpi_ssm_stats_set_enabled(). The data is aggregated per driver and machine
+ * name and can be retrieved using fpi_ssm_stats_get().
  */
 
+typedef enum {
+  FPI_SSM_DELAYED_NEXT_STATE,
+  FPI_SSM_DELAYED_JUMP_TO_STATE,
+  FPI_SSM_DELAYED_MARK_COMPLETED,
+} FpiSsmDelayedAction;
+
 struct _FpiSsm
 {
   FpDevice               *dev;
@@ -82,12 +94,230 @@ struct _FpiSsm
   int                     cur_state;
   gboolean                completed;
   gboolean                silence;
-  GSource                *timeout;
+  guint                   timeout;
+  FpiSsmDelayedAction     delayed_action;
+  int                     delayed_state;
   GError                 *error;
   FpiSsmCompletedCallback callback;
   FpiSsmHandlerCallback   handler;
+  FpiSsmStats            *stats;
+  gint64                  start_time;
+  gint64                  state_time;
 };
 
+/* Command heavy drivers create a machine for every command, keep a few
+ * around instead of hitting the allocator each time. */
+#define FPI_SSM_POOL_SIZE 8
+
+G_LOCK_DEFINE_STATIC (ssm_pool);
+static FpiSsm *ssm_pool[FPI_SSM_POOL_SIZE];
+static guint ssm_pool_len = 0;
+
+/* Machines of different devices may run in different threads */
+G_LOCK_DEFINE_STATIC (ssm_stats);
+static gint ssm_stats_enabled = -1;
+static GHashTable *ssm_stats = NULL;
+
+/**
+ * fpi_ssm_stats_set_enabled:
+ * @enabled: whether to record statistics
+ *
+ * Enables or disables recording of state machine statistics. Only machines
+ * started afterwards are affected.
+ */
+void
+fpi_ssm_stats_set_enabled (gboolean enabled)
+{
+  g_atomic_int_set (&ssm_stats_enabled, !!enabled);
+}
+
+/**
+ * fpi_ssm_stats_get_enabled:
+ *
+ * Returns whether state machine statistics are recorded. Unless changed
+ * with fpi_ssm_stats_set_enabled(), recording is enabled if the
+ * FP_DEBUG_SSM_STATS environment variable is set.
+ *
+ * Returns: %TRUE if statistics are recorded
+ */
+gboolean
+fpi_ssm_stats_get_enabled (void)
+{
+  gint enabled = g_atomic_int_get (&ssm_stats_enabled);
+
+  if (enabled < 0)
+    {
+      enabled = g_getenv ("FP_DEBUG_SSM_STATS") != NULL;
+      g_atomic_int_compare_and_exchange (&ssm_stats_enabled, -1, enabled);
+      enabled = g_atomic_int_get (&ssm_stats_enabled);
+    }
+
+  return enabled;
+}
+
+static void
+fpi_ssm_stats_free (FpiSsmStats *stats)
+{
+  g_free (stats->driver);
+  g_free (stats->name);
+  g_free (stats->states);
+  g_free (stats);
+}
+
+static FpiSsmStats *
+fpi_ssm_stats_copy (const FpiSsmStats *stats)
+{
+  FpiSsmStats *copy = g_memdup2 (stats, sizeof (FpiSsmStats));
+
+  copy->driver = g_strdup (stats->driver);
+  copy->name = g_strdup (stats->name);
+  copy->states = g_memdup2 (stats->states, stats->nr_states * sizeof (FpiSsmHistogram));
+
+  return copy;
+}
+
+/* Must be called with the ssm_stats lock held */
+static FpiSsmStats *
+fpi_ssm_stats_lookup (FpiSsm *machine)
+{
+  FpiSsmStats *stats;
+  const char *driver = fp_device_get_driver (machine->dev);
+  const char *name = machine->name ? machine->name : "";
+  g_autofree char *key = NULL;
+
+  if (!ssm_stats)
+    ssm_stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       (GDestroyNotify) fpi_ssm_stats_free);
+
+  key = g_strdup_printf ("%s/%s", driver, name);
+  stats = g_hash_table_lookup (ssm_stats, key);
+
+  if (!stats)
+    {
+      stats = g_new0 (FpiSsmStats, 1);
+      stats->driver = g_strdup (driver);
+      stats->name = g_strdup (name);
+      g_hash_table_insert (ssm_stats, g_steal_pointer (&key), stats);
+    }
+
+  if (stats->nr_states < machine->nr_states)
+    {
+      stats->states = g_renew (FpiSsmHistogram, stats->states, machine->nr_states);
+      memset (&stats->states[stats->nr_states], 0,
+              (machine->nr_states - stats->nr_states) * sizeof (FpiSsmHistogram));
+      stats->nr_states = machine->nr_states;
+    }
+
+  return stats;
+}
+
+static void
+fpi_ssm_histogram_add (FpiSsmHistogram *histogram, gint64 usec)
+{
+  guint bucket;
+
+  usec = MAX (usec, 0);
+  bucket = usec > 0 ? g_bit_storage (usec) - 1 : 0;
+  bucket = MIN (bucket, FPI_SSM_HISTOGRAM_BUCKETS - 1);
+
+  histogram->count++;
+  histogram->total_us += usec;
+  histogram->max_us = MAX (histogram->max_us, usec);
+  histogram->buckets[bucket]++;
+}
+
+static void
+fpi_ssm_stats_leave_state (FpiSsm *machine)
+{
+  if (!machine->stats || !machine->state_time)
+    return;
+
+  G_LOCK (ssm_stats);
+  fpi_ssm_histogram_add (&machine->stats->states[machine->cur_state],
+                         g_get_monotonic_time () - machine->state_time);
+  G_UNLOCK (ssm_stats);
+  machine->state_time = 0;
+}
+
+static gint
+compare_stats (gconstpointer a, gconstpointer b)
+{
+  const FpiSsmStats *stats_a = *((FpiSsmStats **) a);
+  const FpiSsmStats *stats_b = *((FpiSsmStats **) b);
+  gint res;
+
+  res = g_strcmp0 (stats_a->driver, stats_b->driver);
+  if (res != 0)
+    return res;
+
+  return g_strcmp0 (stats_a->name, stats_b->name);
+}
+
+/**
+ * fpi_ssm_stats_get:
+ * @driver: (nullable): a driver ID, or %NULL for all drivers
+ *
+ * Retrieves the statistics recorded for the state machines of @driver,
+ * sorted by driver and machine name. The entries are a snapshot, they are
+ * not updated as machines continue to run.
+ *
+ * Returns: (transfer full) (element-type FpiSsmStats): the statistics
+ */
+GPtrArray *
+fpi_ssm_stats_get (const char *driver)
+{
+  GPtrArray *res = g_ptr_array_new_with_free_func ((GDestroyNotify) fpi_ssm_stats_free);
+  GHashTableIter iter;
+  FpiSsmStats *stats;
+
+  G_LOCK (ssm_stats);
+
+  if (ssm_stats)
+    {
+      g_hash_table_iter_init (&iter, ssm_stats);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &stats))
+        if (driver == NULL || g_strcmp0 (stats->driver, driver) == 0)
+          g_ptr_array_add (res, fpi_ssm_stats_copy (stats));
+    }
+
+  G_UNLOCK (ssm_stats);
+
+  g_ptr_array_sort (res, compare_stats);
+
+  return res;
+}
+
+/**
+ * fpi_ssm_stats_reset:
+ *
+ * Clears all recorded state machine statistics.
+ */
+void
+fpi_ssm_stats_reset (void)
+{
+  GHashTableIter iter;
+  FpiSsmStats *stats;
+
+  G_LOCK (ssm_stats);
+
+  if (!ssm_stats)
+    {
+      G_UNLOCK (ssm_stats);
+      return;
+    }
+
+  /* Running machines may still reference the entries, so only clear them */
+  g_hash_table_iter_init (&iter, ssm_stats);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &stats))
+    {
+      memset (stats->states, 0, stats->nr_states * sizeof (FpiSsmHistogram));
+      memset (&stats->run, 0, sizeof (FpiSsmHistogram));
+      stats->delayed_transitions = 0;
+    }
+
+  G_UNLOCK (ssm_stats);
+}
+
 /**
  * fpi_ssm_new:
  * @dev: a #fp_dev fingerprint device
@@ -103,6 +333,34 @@ struct _FpiSsm
  * Returns: a new #FpiSsm state machine
  */
 
+static FpiSsm *
+fpi_ssm_alloc (void)
+{
+  FpiSsm *machine = NULL;
+
+  G_LOCK (ssm_pool);
+  if (ssm_pool_len > 0)
+    machine = ssm_pool[--ssm_pool_len];
+  G_UNLOCK (ssm_pool);
+
+  if (!machine)
+    return g_new0 (FpiSsm, 1);
+
+  memset (machine, 0, sizeof (FpiSsm));
+  return machine;
+}
+
+static void
+fpi_ssm_release (FpiSsm *machine)
+{
+  G_LOCK (ssm_pool);
+  if (ssm_pool_len < FPI_SSM_POOL_SIZE)
+    ssm_pool[ssm_pool_len++] = g_steal_pointer (&machine);
+  G_UNLOCK (ssm_pool);
+
+  g_free (machine);
+}
+
 /**
  * fpi_ssm_new_full:
  * @dev: a #fp_dev fingerprint device
@@ -114,6 +372,9 @@ struct _FpiSsm
  * Allocate a new ssm, with @nr_states states. The @handler callback
  * will be called after each state transition.
  *
+ * The @machine_name is interned, so it should be one of a fixed set of
+ * names rather than generated dynamically.
+ *
  * Returns: a new #FpiSsm state machine
  */
 FpiSsm *
@@ -131,12 +392,12 @@ fpi_ssm_new_full (FpDevice             *dev,
   BUG_ON (start_cleanup > nr_states);
   BUG_ON (handler == NULL);
 
-  machine = g_new0 (FpiSsm, 1);
+  machine = fpi_ssm_alloc ();
   machine->handler = handler;
   machine->nr_states = nr_states;
   machine->start_cleanup = start_cleanup;
   machine->dev = dev;
-  machine->name = g_strdup (machine_name);
+  machine->name = g_intern_string (machine_name);
   machine->completed = TRUE;
   return machine;
 }
@@ -200,25 +461,59 @@ fpi_ssm_clear_delayed_action (FpiSsm *machine)
 {
   g_return_if_fail (machine);
 
-  g_clear_pointer (&machine->timeout, g_source_destroy);
+  if (!machine->timeout)
+    return;
+
+  fpi_device_remove_timer (machine->dev, machine->timeout);
+  machine->timeout = 0;
+}
+
+static void
+on_device_timeout (FpDevice *dev,
+                   gpointer  user_data)
+{
+  FpiSsm *machine = user_data;
+
+  machine->timeout = 0;
+
+  switch (machine->delayed_action)
+    {
+    case FPI_SSM_DELAYED_NEXT_STATE:
+      fpi_ssm_next_state (machine);
+      break;
+
+    case FPI_SSM_DELAYED_JUMP_TO_STATE:
+      fpi_ssm_jump_to_state (machine, machine->delayed_state);
+      break;
+
+    case FPI_SSM_DELAYED_MARK_COMPLETED:
+      fpi_ssm_mark_completed (machine);
+      break;
+    }
 }
 
 static void
-fpi_ssm_set_delayed_action_timeout (FpiSsm        *machine,
-                                    int            delay,
-                                    FpTimeoutFunc  callback,
-                                    gpointer       user_data,
-                                    GDestroyNotify destroy_func)
+fpi_ssm_set_delayed_action_timeout (FpiSsm             *machine,
+                                    int                 delay,
+                                    FpiSsmDelayedAction action,
+                                    int                 state)
 {
   g_return_if_fail (machine);
 
   BUG_ON (machine->completed);
-  BUG_ON (machine->timeout != NULL);
+  BUG_ON (machine->timeout);
 
-  fpi_ssm_clear_delayed_action (machine);
+  if (machine->stats)
+    {
+      G_LOCK (ssm_stats);
+      machine->stats->delayed_transitions++;
+      G_UNLOCK (ssm_stats);
+    }
 
-  machine->timeout = fpi_device_add_timeout (machine->dev, delay, callback,
-                                             user_data, destroy_func);
+  machine->delayed_action = action;
+  machine->delayed_state = state;
+  machine->timeout = fpi_device_add_timer (machine->dev, delay,
+                                           on_device_timeout, machine, NULL);
 }
 
 /**
@@ -234,14 +529,12 @@ fpi_ssm_free (FpiSsm *machine)
   if (!machine)
     return;
 
-  BUG_ON (machine->timeout != NULL);
+  BUG_ON (machine->timeout);
 
   if (machine->ssm_data_destroy)
     g_clear_pointer (&machine->ssm_data, machine->ssm_data_destroy);
   g_clear_pointer (&machine->error, g_error_free);
-  g_clear_pointer (&machine->name, g_free);
-  fpi_ssm_clear_delayed_action (machine);
-  g_free (machine);
+  fpi_ssm_release (machine);
 }
 
 /* Invoke the state handler */
@@ -251,6 +544,8 @@ __ssm_call_handler (FpiSsm *machine, gboolean force_msg)
   if (force_msg || !machine->silence)
     fp_dbg ("[%s] %s entering state %d", fp_device_get_driver (machine->dev),
             machine->name, machine->cur_state);
+  if (machine->stats)
+    machine->state_time = g_get_monotonic_time ();
   machine->handler (machine, machine->dev);
 }
 
@@ -277,6 +572,15 @@ fpi_ssm_start (FpiSsm *ssm, FpiSsmCompletedCallback callback)
   ssm->cur_state = 0;
   ssm->completed = FALSE;
   ssm->error = NULL;
+
+  if (fpi_ssm_stats_get_enabled ())
+    {
+      G_LOCK (ssm_stats);
+      ssm->stats = fpi_ssm_stats_lookup (ssm);
+      G_UNLOCK (ssm_stats);
+      ssm->start_time = g_get_monotonic_time ();
+    }
+
   __ssm_call_handler (ssm, TRUE);
 }
 
@@ -335,9 +639,10 @@ fpi_ssm_mark_completed (FpiSsm *machine)
   g_return_if_fail (machine != NULL);
 
   BUG_ON (machine->completed);
-  BUG_ON (machine->timeout != NULL);
+  BUG_ON (machine->timeout);
 
   fpi_ssm_clear_delayed_action (machine);
+  fpi_ssm_stats_leave_state (machine);
 
   /* complete in a cleanup state just moves forward one step */
   if (machine->cur_state < machine->start_cleanup)
@@ -354,6 +659,14 @@ fpi_ssm_mark_completed (FpiSsm *machine)
 
   machine->completed = TRUE;
 
+  if (machine->stats)
+    {
+      G_LOCK (ssm_stats);
+      fpi_ssm_histogram_add (&machine->stats->run,
+                             g_get_monotonic_time () - machine->start_time);
+      G_UNLOCK (ssm_stats);
+    }
+
   if (machine->error)
     fp_dbg ("[%s] %s completed with error: %s", fp_device_get_driver (machine->dev),
             machine->name, machine->error->message);
@@ -369,16 +682,6 @@ fpi_ssm_mark_completed (FpiSsm *machine)
   fpi_ssm_free (machine);
 }
 
-static void
-on_device_timeout_complete (FpDevice *dev,
-                            gpointer  user_data)
-{
-  FpiSsm *machine = user_data;
-
-  machine->timeout = NULL;
-  fpi_ssm_mark_completed (machine);
-}
-
 /**
  * fpi_ssm_mark_completed_delayed:
  * @machine: an #FpiSsm state machine
@@ -392,18 +695,10 @@ void
 fpi_ssm_mark_completed_delayed (FpiSsm *machine,
                                 int     delay)
 {
-  g_autofree char *source_name = NULL;
-
   g_return_if_fail (machine != NULL);
 
   fpi_ssm_set_delayed_action_timeout (machine, delay,
-                                      on_device_timeout_complete,
-                                      machine, NULL);
-
-  source_name = g_strdup_printf ("[%s] ssm %s complete %d",
-                                 fp_device_get_device_id (machine->dev),
-                                 machine->name, machine->cur_state + 1);
-  g_source_set_name (machine->timeout, source_name);
+                                      FPI_SSM_DELAYED_MARK_COMPLETED, 0);
 }
 
 /**
@@ -454,9 +749,10 @@ fpi_ssm_next_state (FpiSsm *machine)
   g_return_if_fail (machine != NULL);
 
   BUG_ON (machine->completed);
-  BUG_ON (machine->timeout != NULL);
+  BUG_ON (machine->timeout);
 
   fpi_ssm_clear_delayed_action (machine);
+  fpi_ssm_stats_leave_state (machine);
 
   machine->cur_state++;
   if (machine->cur_state == machine->nr_states)
@@ -470,7 +766,7 @@ fpi_ssm_cancel_delayed_state_change (FpiSsm *machine)
 {
   g_return_if_fail (machine);
   BUG_ON (machine->completed);
-  BUG_ON (machine->timeout == NULL);
+  BUG_ON (!machine->timeout);
 
   fp_dbg ("[%s] %s cancelled delayed state change",
           fp_device_get_driver (machine->dev), machine->name);
@@ -478,16 +774,6 @@ fpi_ssm_cancel_delayed_state_change (FpiSsm *machine)
   fpi_ssm_clear_delayed_action (machine);
 }
 
-static void
-on_device_timeout_next_state (FpDevice *dev,
-                              gpointer  user_data)
-{
-  FpiSsm *machine = user_data;
-
-  machine->timeout = NULL;
-  fpi_ssm_next_state (machine);
-}
-
 /**
  * fpi_ssm_next_state_delayed:
  * @machine: an #FpiSsm state machine
@@ -501,18 +787,10 @@ void
 fpi_ssm_next_state_delayed (FpiSsm *machine,
                             int     delay)
 {
-  g_autofree char *source_name = NULL;
-
   g_return_if_fail (machine != NULL);
 
   fpi_ssm_set_delayed_action_timeout (machine, delay,
-                                      on_device_timeout_next_state,
-                                      machine, NULL);
-
-  source_name = g_strdup_printf ("[%s] ssm %s jump to next state %d",
-                                 fp_device_get_device_id (machine->dev),
-                                 machine->name, machine->cur_state + 1);
-  g_source_set_name (machine->timeout, source_name);
+                                      FPI_SSM_DELAYED_NEXT_STATE, 0);
 }
 
 /**
@@ -531,9 +809,10 @@ fpi_ssm_jump_to_state (FpiSsm *machine, int state)
 
   BUG_ON (machine->completed);
   BUG_ON (state < 0 || state > machine->nr_states);
-  BUG_ON (machine->timeout != NULL);
+  BUG_ON (machine->timeout);
 
   fpi_ssm_clear_delayed_action (machine);
+  fpi_ssm_stats_leave_state (machine);
 
   machine->cur_state = state;
   if (machine->cur_state == machine->nr_states)
@@ -542,22 +821,6 @@ fpi_ssm_jump_to_state (FpiSsm *machine, int state)
     __ssm_call_handler (machine, FALSE);
 }
 
-typedef struct
-{
-  FpiSsm *machine;
-  int     next_state;
-} FpiSsmJumpToStateDelayedData;
-
-static void
-on_device_timeout_jump_to_state (FpDevice *dev,
-                                 gpointer  user_data)
-{
-  FpiSsmJumpToStateDelayedData *data = user_data;
-
-  data->machine->timeout = NULL;
-  fpi_ssm_jump_to_state (data->machine, data->next_state);
-}
-
 /**
  * fpi_ssm_jump_to_state_delayed:
  * @machine: an #FpiSsm state machine
@@ -572,24 +835,11 @@ fpi_ssm_jump_to_state_delayed (FpiSsm *machine,
                                int     state,
                                int     delay)
 {
-  FpiSsmJumpToStateDelayedData *data;
-  g_autofree char *source_name = NULL;
-
   g_return_if_fail (machine != NULL);
   BUG_ON (state < 0 || state > machine->nr_states);
 
-  data = g_new0 (FpiSsmJumpToStateDelayedData, 1);
-  data->machine = machine;
-  data->next_state = state;
-
   fpi_ssm_set_delayed_action_timeout (machine, delay,
-                                      on_device_timeout_jump_to_state,
-                                      data, g_free);
-
-  source_name = g_strdup_printf ("[%s] ssm %s jump to state %d",
-                                 fp_device_get_device_id (machine->dev),
-                                 machine->name, state);
-  g_source_set_name (machine->timeout, source_name);
+                                      FPI_SSM_DELAYED_JUMP_TO_STATE, state);
 }
 
 /**
@@ -98,6 +98,54 @@ int fpi_ssm_get_cur_state (FpiSsm *machine);
 
 void fpi_ssm_silence_debug (FpiSsm *machine);
 
+#define FPI_SSM_HISTOGRAM_BUCKETS 24
+
+/**
+ * FpiSsmHistogram:
+ * @count: number of recorded durations
+ * @total_us: sum of all durations in microseconds
+ * @max_us: longest duration in microseconds
+ * @buckets: number of durations per bucket; bucket n counts durations of at
+ *   least 2^n and less than 2^(n+1) microseconds, bucket 0 also includes
+ *   zero and the last bucket includes all longer durations
+ *
+ * Histogram of durations recorded for a state machine.
+ */
+typedef struct
+{
+  guint  count;
+  gint64 total_us;
+  gint64 max_us;
+  guint  buckets[FPI_SSM_HISTOGRAM_BUCKETS];
+} FpiSsmHistogram;
+
+/**
+ * FpiSsmStats:
+ * @driver: the driver ID
+ * @name: the name of the state machine
+ * @nr_states: the number of entries in @states
+ * @states: the time spent in each state
+ * @run: the time from fpi_ssm_start() until completion
+ * @delayed_transitions: the number of delayed state changes that were scheduled
+ *
+ * Statistics aggregated over all runs of the state machines with the same
+ * name for a driver.
+ */
+typedef struct
+{
+  char            *driver;
+  char            *name;
+  int              nr_states;
+  FpiSsmHistogram *states;
+  FpiSsmHistogram  run;
+  guint            delayed_transitions;
+} FpiSsmStats;
+
+void fpi_ssm_stats_set_enabled (gboolean enabled);
+gboolean fpi_ssm_stats_get_enabled (void);
+GPtrArray * fpi_ssm_stats_get (const char *driver);
+void fpi_ssm_stats_reset (void);
+
 /* Callbacks to be used by the driver instead of implementing their own
  * logic.
  */
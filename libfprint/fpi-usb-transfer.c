@@ -18,6 +18,7 @@
  */
 
 #include "fpi-usb-transfer.h"
+#include "fpi-metrics.h"
 
 /**
  * SECTION:fpi-usb-transfer
@@ -299,6 +300,28 @@ fpi_usb_transfer_fill_interrupt_full (FpiUsbTransfer *transfer,
   transfer->free_buffer = free_func;
 }
 
+static void
+update_transfer_metrics (FpiUsbTransfer *transfer, GError *error)
+{
+  gboolean is_in;
+
+  if (error)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        fpi_device_metrics_add (transfer->device, FPI_METRIC_USB_TRANSFER_ERRORS, 1);
+      return;
+    }
+
+  if (transfer->type == FP_TRANSFER_CONTROL)
+    is_in = transfer->direction == G_USB_DEVICE_DIRECTION_DEVICE_TO_HOST;
+  else
+    is_in = !!(transfer->endpoint & FPI_USB_ENDPOINT_IN);
+
+  fpi_device_metrics_add (transfer->device,
+                          is_in ? FPI_METRIC_USB_BYTES_IN : FPI_METRIC_USB_BYTES_OUT,
+                          transfer->actual_length);
+}
+
 static void
 transfer_finish_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
@@ -335,6 +358,7 @@ transfer_finish_cb (GObject *source_object, GAsyncResult *res, gpointer user_dat
     }
 
   log_transfer (transfer, FALSE, error);
+  update_transfer_metrics (transfer, error);
 
   /* Check for short error, and set an error if requested */
   if (error == NULL &&
@@ -412,8 +436,8 @@ fpi_usb_transfer_submit (FpiUsbTransfer        *transfer,
    */
   if (cancellable && g_cancellable_is_cancelled (cancellable))
     {
-      fpi_device_add_timeout (transfer->device, 0,
-                              transfer_cancel_cb, transfer, NULL);
+      fpi_device_add_timer (transfer->device, 0,
+                            transfer_cancel_cb, transfer, NULL);
       return;
     }
 
@@ -0,0 +1,95 @@
+/*
+ * Generate the USB ID table used for matching devices to drivers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "fpi-context.h"
+#include "fpi-device.h"
+
+/* This tool is linked against the core sources directly, so it needs to
+ * provide the table that it is going to generate. */
+const FpiUsbIdEntry fpi_usb_id_table[] = { { 0 } };
+const gboolean fpi_usb_id_table_valid = FALSE;
+
+static gint
+usb_id_entry_compare (gconstpointer a, gconstpointer b)
+{
+  const FpiUsbIdEntry *entry_a = a;
+  const FpiUsbIdEntry *entry_b = b;
+
+  if (entry_a->vid != entry_b->vid)
+    return entry_a->vid - entry_b->vid;
+
+  if (entry_a->pid != entry_b->pid)
+    return entry_a->pid - entry_b->pid;
+
+  return g_strcmp0 (entry_a->driver, entry_b->driver);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_autoptr(GArray) entries = g_array_new (FALSE, FALSE, sizeof (FpiUsbIdEntry));
+  const FpiDriverInfo *infos;
+  guint n_infos;
+  guint i;
+
+  infos = fpi_get_driver_infos (&n_infos);
+
+  for (i = 0; i < n_infos; i++)
+    {
+      g_autoptr(FpDeviceClass) cls = g_type_class_ref (infos[i].get_type ());
+      const FpIdEntry *entry;
+
+      /* The build system guesses the type, make sure it is right */
+      if (g_strcmp0 (cls->id, infos[i].id) != 0 || cls->type != infos[i].type)
+        g_error ("Driver %s does not match its build time information", infos[i].id);
+
+      if (cls->type != FP_DEVICE_TYPE_USB)
+        continue;
+
+      for (entry = cls->id_table; entry->vid; entry++)
+        {
+          FpiUsbIdEntry usb_id = { entry->vid, entry->pid, infos[i].id };
+
+          g_array_append_val (entries, usb_id);
+        }
+    }
+
+  g_array_sort (entries, usb_id_entry_compare);
+
+  g_print ("/* Generated by fprint-list-usb-ids, do not edit */\n");
+  g_print ("#include \"fpi-context.h\"\n");
+  g_print ("\n");
+  g_print ("const FpiUsbIdEntry fpi_usb_id_table[] = {\n");
+
+  for (i = 0; i < entries->len; i++)
+    {
+      FpiUsbIdEntry *usb_id = &g_array_index (entries, FpiUsbIdEntry, i);
+
+      g_print ("  { 0x%04x, 0x%04x, \"%s\" },\n",
+               usb_id->vid, usb_id->pid, usb_id->driver);
+    }
+
+  g_print ("  { 0 }\n");
+  g_print ("};\n");
+  g_print ("\n");
+  g_print ("const gboolean fpi_usb_id_table_valid = TRUE;\n");
+
+  return 0;
+}
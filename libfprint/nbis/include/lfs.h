@@ -145,6 +145,61 @@ typedef struct rotgrids{
    int **grids;
 } ROTGRIDS;
 
+/* Working memory for lfs_detect_minutiae_V2() which is kept between   */
+/* calls.  The lookup tables are only rebuilt when the image dimensions */
+/* or the LFS parameters they were built from change, and the buffers   */
+/* only ever grow, so repeated detections on images of the same size    */
+/* do not allocate any of them again.                                   */
+typedef struct mindtct_workspace{
+   /* Keys of the cached lookup tables. */
+   int iw;
+   int ih;
+   int maxpad;
+   int num_directions;
+   double start_dir_angle;
+   int num_dft_waves;
+   int windowsize;
+   int dirbin_grid_w;
+   int dirbin_grid_h;
+
+   DIR2RAD *dir2rad;
+   DFTWAVES *dftwaves;
+   ROTGRIDS *dftgrids;
+   ROTGRIDS *dirbingrids;
+
+   /* Padded copy of the input image. */
+   unsigned char *pdata;
+   int pdata_alloc;
+
+   /* Block maps, all of the same dimensions. */
+   int *direction_map;
+   int *low_contrast_map;
+   int *low_flow_map;
+   int *high_curve_map;
+   int *quality_map;
+   int map_alloc;
+
+   /* DFT power vectors and statistics. */
+   double **powers;
+   int powers_nwaves;
+   int powers_ndirs;
+   int *wis;
+   double *powmaxs;
+   int *powmax_dirs;
+   double *pownorms;
+
+   /* Optional callback polled between processing steps.  Detection */
+   /* stops with LFS_ABORTED as soon as it returns non-zero.         */
+   int (*abort_func)(void *);
+   void *abort_data;
+} MINDTCT_WORKSPACE;
+
+/* Return code of a detection that was stopped by the abort callback. */
+#define LFS_ABORTED          -1000
+
+#define lfs_aborted(ws) \
+   ((ws)->abort_func != NULL && (ws)->abort_func((ws)->abort_data))
+
 /*************************************************************************/
 /* 10, 2X3 pixel pair feature patterns used to define ridge endings      */
 /* and bifurcations.                                                     */
@@ -785,7 +840,7 @@ extern int lfs_detect_minutiae_V2(MINUTIAE **,
                      int **, int **, int **, int **, int *, int *,
                      unsigned char **, int *, int *,
                      unsigned char *, const int, const int,
-                     const LFSPARMS *);
+                     const LFSPARMS *, MINDTCT_WORKSPACE *);
 
 /* dft.c */
 extern int dft_dir_powers(double **, unsigned char *, const int,
@@ -804,13 +859,15 @@ extern void free_dir2rad(DIR2RAD *);
 extern void free_dftwaves(DFTWAVES *);
 extern void free_rotgrids(ROTGRIDS *);
 extern void free_dir_powers(double **, const int);
+extern void free_workspace(MINDTCT_WORKSPACE *);
 
 /* getmin.c */
 extern int get_minutiae(MINUTIAE **, int **, int **, int **,
                  int **, int **, int *, int *,
                  unsigned char **, int *, int *, int *,
                  unsigned char *, const int, const int,
-                 const int, const double, const LFSPARMS *);
+                 const int, const double, const LFSPARMS *,
+                 MINDTCT_WORKSPACE *);
 
 /* imgutil.c */
 extern void bits_6to8(unsigned char *, const int, const int);
@@ -820,6 +877,8 @@ extern void gray2bin(const int, const int, const int,
 extern int pad_uchar_image(unsigned char **, int *, int *,
                      unsigned char *, const int, const int, const int,
                      const int);
+extern void copy_pad_uchar_image(unsigned char *, unsigned char *,
+                     const int, const int, const int, const int);
 extern void fill_holes(unsigned char *, const int, const int);
 extern int free_path(const int, const int, const int, const int,
                      unsigned char *, const int, const int, const LFSPARMS *);
@@ -836,6 +895,12 @@ extern int init_rotgrids(ROTGRIDS **, const int, const int, const int,
                      const double, const int, const int, const int, const int);
 extern int alloc_dir_powers(double ***, const int, const int);
 extern int alloc_power_stats(int **, double **, int **, double **, const int);
+extern int alloc_workspace(MINDTCT_WORKSPACE **);
+extern int init_workspace_tables(MINDTCT_WORKSPACE *, const int, const int,
+                     const int, const LFSPARMS *);
+extern int alloc_workspace_image(MINDTCT_WORKSPACE *, const int);
+extern int alloc_workspace_maps(MINDTCT_WORKSPACE *, const int);
+extern int alloc_workspace_powers(MINDTCT_WORKSPACE *, const int, const int);
 
 /* isempty.c */
 extern int is_image_empty(int *, const int, const int);
@@ -899,11 +964,13 @@ extern void flood_fill4(const int, const int, const int,
 extern int gen_image_maps(int **, int **, int **, int **, int *, int *,
                     unsigned char *, const int, const int,
                     const DIR2RAD *, const DFTWAVES *,
-                    const ROTGRIDS *, const LFSPARMS *);
+                    const ROTGRIDS *, const LFSPARMS *,
+                    MINDTCT_WORKSPACE *);
 extern int gen_initial_maps(int **, int **, int **,
                     int *, const int, const int,
                     unsigned char *, const int, const int,
-                    const DFTWAVES *, const  ROTGRIDS *, const LFSPARMS *);
+                    const DFTWAVES *, const  ROTGRIDS *, const LFSPARMS *,
+                    MINDTCT_WORKSPACE *);
 extern int interpolate_direction_map(int *, int *, const int, const int,
                     const LFSPARMS *);
 extern int morph_TF_map(int *, const int, const int, const LFSPARMS *);
@@ -912,7 +979,7 @@ extern int pixelize_map(int **, const int, const int,
 extern void smooth_direction_map(int *, int *, const int, const int,
                      const DIR2RAD *, const LFSPARMS *);
 extern int gen_high_curve_map(int **, int *, const int, const int,
-                     const LFSPARMS *);
+                     const LFSPARMS *, MINDTCT_WORKSPACE *);
 extern int gen_imap(int **, int *, int *,
                      unsigned char *, const int, const int,
                      const DIR2RAD *, const DFTWAVES *, const ROTGRIDS *,
@@ -1076,7 +1143,7 @@ extern int get_low_curvature_direction(const int, const int, const int,
 
 /* quality.c */
 extern int gen_quality_map(int **, int *, int *, int *, int *,
-                     const int, const int);
+                     const int, const int, MINDTCT_WORKSPACE *);
 extern int combined_minutia_quality(MINUTIAE *, int *, const int, const int,
                      const int, unsigned char *, const int, const int,
                      const int, const double);
@@ -73,6 +73,28 @@ of the software.
 #include <stdio.h>
 #include <lfs.h>
 
+/* Contours are traced for nearly every minutia during detection and  */
+/* removal, so the blocks backing them are recycled per thread rather */
+/* than being returned to the allocator each time.                    */
+#define CONTOUR_CACHE_BLOCKS  8
+
+typedef struct contour_cache{
+   int nblocks;
+   int *blocks[CONTOUR_CACHE_BLOCKS];
+} CONTOUR_CACHE;
+
+static void free_contour_cache(void *data)
+{
+   CONTOUR_CACHE *cache = (CONTOUR_CACHE *)data;
+   int i;
+
+   for(i = 0; i < cache->nblocks; i++)
+      g_free(cache->blocks[i]);
+   g_free(cache);
+}
+
+static GPrivate contour_cache_key = G_PRIVATE_INIT(free_contour_cache);
+
 /*************************************************************************
 **************************************************************************
 #cat: allocate_contour - Allocates the lists needed to represent the
@@ -89,7 +111,8 @@ of the software.
 #cat:            second set is NOT guaranteed to be 8-connected and its points
 #cat:            are opposite the color of the feature.  Remeber that "feature"
 #cat:            means either ridge-ending (black pixels) or valley-ending
-#cat:            (white pixels).
+#cat:            (white pixels).  Memory of contours previously released
+#cat:            with free_contour() by the same thread is reused.
 
    Input:
       ncontour    - number of items in each coordinate list to be allocated
@@ -105,27 +128,37 @@ of the software.
 int allocate_contour(int **ocontour_x, int **ocontour_y,
                      int **ocontour_ex, int **ocontour_ey, const int ncontour)
 {
-   int *contour_x, *contour_y, *contour_ex, *contour_ey;
-
-   ASSERT_SIZE_MUL(ncontour, sizeof(int));
-
-   /* Allocate contour's x-coord list. */
-   contour_x = (int *)g_malloc(ncontour * sizeof(int));
-
-   /* Allocate contour's y-coord list. */
-   contour_y = (int *)g_malloc(ncontour * sizeof(int));
+   CONTOUR_CACHE *cache;
+   int *block;
+   int i;
 
-   /* Allocate contour's edge x-coord list. */
-   contour_ex = (int *)g_malloc(ncontour * sizeof(int));
+   ASSERT_SIZE_MUL(ncontour, 4 * sizeof(int));
+
+   /* Reuse a previously freed block that is large enough, if any. */
+   block = NULL;
+   cache = g_private_get(&contour_cache_key);
+   if(cache != NULL){
+      for(i = 0; i < cache->nblocks; i++){
+         if(cache->blocks[i][0] >= ncontour){
+            block = cache->blocks[i];
+            cache->blocks[i] = cache->blocks[--cache->nblocks];
+            break;
+         }
+      }
+   }
 
-   /* Allocate contour's edge y-coord list. */
-   contour_ey = (int *)g_malloc(ncontour * sizeof(int));
+   /* Otherwise, allocate a single block holding all four lists, */
+   /* preceded by its capacity.                                  */
+   if(block == NULL){
+      block = (int *)g_malloc(((4 * ncontour) + 1) * sizeof(int));
+      block[0] = ncontour;
+   }
 
-   /* Otherwise, allocations successful, so assign output pointers. */
-   *ocontour_x = contour_x;
-   *ocontour_y = contour_y;
-   *ocontour_ex = contour_ex;
-   *ocontour_ey = contour_ey;
+   /* Assign output pointers into the block. */
+   *ocontour_x = block + 1;
+   *ocontour_y = *ocontour_x + block[0];
+   *ocontour_ex = *ocontour_y + block[0];
+   *ocontour_ey = *ocontour_ex + block[0];
 
    /* Return normally. */
    return(0);
@@ -142,6 +175,8 @@ int allocate_contour(int **ocontour_x, int **ocontour_y,
 #cat:            adjacent to its respective feature contour point in the first
 #cat:            list and on the exterior of the feature.  These second points
 #cat:            are called the feature's "edge points".
+#cat:            The lists must have been allocated by allocate_contour(),
+#cat:            their memory is kept for reuse by the calling thread.
 
    Input:
       contour_x  - x-coord list for feature's contour points
@@ -152,10 +187,24 @@ int allocate_contour(int **ocontour_x, int **ocontour_y,
 void free_contour(int *contour_x, int *contour_y,
                   int *contour_ex, int *contour_ey)
 {
-   g_free(contour_x);
-   g_free(contour_y);
-   g_free(contour_ex);
-   g_free(contour_ey);
+   CONTOUR_CACHE *cache;
+   int *block;
+
+   /* All four lists share the block allocated for contour_x. */
+   if(contour_x == NULL)
+      return;
+   block = contour_x - 1;
+
+   cache = g_private_get(&contour_cache_key);
+   if(cache == NULL){
+      cache = (CONTOUR_CACHE *)g_malloc0(sizeof(CONTOUR_CACHE));
+      g_private_set(&contour_cache_key, cache);
+   }
+
+   if(cache->nblocks < CONTOUR_CACHE_BLOCKS)
+      cache->blocks[cache->nblocks++] = block;
+   else
+      g_free(block);
 }
 
 /*************************************************************************
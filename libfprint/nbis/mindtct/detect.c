@@ -111,16 +111,17 @@ of the software.
       iw        - width (in pixels) of the image
       ih        - height (in pixels) of the image
       lfsparms  - parameters and thresholds for controlling LFS
+      ws        - workspace providing lookup tables and working memory
 
    Output:
       ominutiae - resulting list of minutiae
-      odmap     - resulting Direction Map
+      odmap     - resulting Direction Map (owned by ws)
                   {invalid (-1) or valid ridge directions}
-      olcmap    - resulting Low Contrast Map
+      olcmap    - resulting Low Contrast Map (owned by ws)
                   {low contrast (TRUE), high contrast (FALSE)}
-      olfmap    - resulting Low Ridge Flow Map
+      olfmap    - resulting Low Ridge Flow Map (owned by ws)
                   {low ridge flow (TRUE), high ridge flow (FALSE)}
-      ohcmap    - resulting High Curvature Map
+      ohcmap    - resulting High Curvature Map (owned by ws)
                   {high curvature (TRUE), low curvature (FALSE)}
       omw       - width (in blocks) of image maps
       omh       - height (in blocks) of image maps
@@ -130,6 +131,7 @@ of the software.
       obh       - height (in pixels) of the binary image
    Return Code:
       Zero      - successful completion
+      LFS_ABORTED - stopped by the abort callback of the workspace
       Negative  - system error
 **************************************************************************/
 int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
@@ -137,14 +139,10 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
                         int *omw, int *omh,
                         unsigned char **obdata, int *obw, int *obh,
                         unsigned char *idata, const int iw, const int ih,
-                        const LFSPARMS *lfsparms)
+                        const LFSPARMS *lfsparms, MINDTCT_WORKSPACE *ws)
 {
    unsigned char *pdata, *bdata;
    int pw, ph, bw, bh;
-   DIR2RAD *dir2rad;
-   DFTWAVES *dftwaves;
-   ROTGRIDS *dftgrids;
-   ROTGRIDS *dirbingrids;
    int *direction_map, *low_contrast_map, *low_flow_map, *high_curve_map;
    int mw, mh;
    int ret, maxpad;
@@ -166,52 +164,20 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
    maxpad = get_max_padding_V2(lfsparms->windowsize, lfsparms->windowoffset,
                           lfsparms->dirbin_grid_w, lfsparms->dirbin_grid_h);
 
-   /* Initialize lookup table for converting integer directions */
-   /* to angles in radians.                                     */
-   if((ret = init_dir2rad(&dir2rad, lfsparms->num_directions))){
-      /* Free memory allocated to this point. */
+   /* Initialize (or reuse) the lookup tables for converting integer */
+   /* directions to radians, the DFT wave forms and the pixel offsets */
+   /* to rotated grids used for DFT analyses and binarization.        */
+   if((ret = init_workspace_tables(ws, iw, ih, maxpad, lfsparms)))
       return(ret);
-   }
 
-   /* Initialize wave form lookup tables for DFT analyses. */
-   /* used for direction binarization.                             */
-   if((ret = init_dftwaves(&dftwaves, g_dft_coefs, lfsparms->num_dft_waves,
-                        lfsparms->windowsize))){
-      /* Free memory allocated to this point. */
-      free_dir2rad(dir2rad);
+   /* Pad input image based on max padding (may not need to pad at */
+   /* all, in which case this is a plain copy of the input image). */
+   pw = iw + (maxpad<<1);
+   ph = ih + (maxpad<<1);
+   if((ret = alloc_workspace_image(ws, pw * ph)))
       return(ret);
-   }
-
-   /* Initialize lookup table for pixel offsets to rotated grids */
-   /* used for DFT analyses.                                     */
-   if((ret = init_rotgrids(&dftgrids, iw, ih, maxpad,
-                        lfsparms->start_dir_angle, lfsparms->num_directions,
-                        lfsparms->windowsize, lfsparms->windowsize,
-                        RELATIVE2ORIGIN))){
-      /* Free memory allocated to this point. */
-      free_dir2rad(dir2rad);
-      free_dftwaves(dftwaves);
-      return(ret);
-   }
-
-   /* Pad input image based on max padding. */
-   if(maxpad > 0){   /* May not need to pad at all */
-      if((ret = pad_uchar_image(&pdata, &pw, &ph, idata, iw, ih,
-                             maxpad, lfsparms->pad_value))){
-         /* Free memory allocated to this point. */
-         free_dir2rad(dir2rad);
-         free_dftwaves(dftwaves);
-         free_rotgrids(dftgrids);
-         return(ret);
-      }
-   }
-   else{
-      /* If padding is unnecessary, then copy the input image. */
-      pdata = (unsigned char *)g_malloc(iw * ih);
-      memcpy(pdata, idata, iw*ih);
-      pw = iw;
-      ph = ih;
-   }
+   pdata = ws->pdata;
+   copy_pad_uchar_image(pdata, idata, iw, ih, maxpad, lfsparms->pad_value);
 
    /* Scale input image to 6 bits [0..63] */
    /* !!! Would like to remove this dependency eventualy !!!     */
@@ -223,6 +189,9 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
 
    print2log("\nINITIALIZATION AND PADDING DONE\n");
 
+   if(lfs_aborted(ws))
+      return(LFS_ABORTED);
+
    /******************/
    /*      MAPS      */
    /******************/
@@ -231,69 +200,35 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
    /* Generate block maps from the input image. */
    if((ret = gen_image_maps(&direction_map, &low_contrast_map,
                     &low_flow_map, &high_curve_map, &mw, &mh,
-                    pdata, pw, ph, dir2rad, dftwaves, dftgrids, lfsparms))){
-      /* Free memory allocated to this point. */
-      free_dir2rad(dir2rad);
-      free_dftwaves(dftwaves);
-      free_rotgrids(dftgrids);
-      g_free(pdata);
+                    pdata, pw, ph, ws->dir2rad, ws->dftwaves, ws->dftgrids,
+                    lfsparms, ws))){
       return(ret);
    }
-   /* Deallocate working memories. */
-   free_dir2rad(dir2rad);
-   free_dftwaves(dftwaves);
-   free_rotgrids(dftgrids);
 
    print2log("\nMAPS DONE\n");
 
    time_accum(imap_timer, imap_time);
 
+   /* The maps are owned by the workspace, nothing to free. */
+   if(lfs_aborted(ws))
+      return(LFS_ABORTED);
+
    /******************/
    /* BINARIZARION   */
    /******************/
    set_timer(bin_timer);
 
-   /* Initialize lookup table for pixel offsets to rotated grids */
-   /* used for directional binarization.                         */
-   if((ret = init_rotgrids(&dirbingrids, iw, ih, maxpad,
-                        lfsparms->start_dir_angle, lfsparms->num_directions,
-                        lfsparms->dirbin_grid_w, lfsparms->dirbin_grid_h,
-                        RELATIVE2CENTER))){
-      /* Free memory allocated to this point. */
-      g_free(pdata);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
-      return(ret);
-   }
-
    /* Binarize input image based on NMAP information. */
    if((ret = binarize_V2(&bdata, &bw, &bh,
                       pdata, pw, ph, direction_map, mw, mh,
-                      dirbingrids, lfsparms))){
-      /* Free memory allocated to this point. */
-      g_free(pdata);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
-      free_rotgrids(dirbingrids);
+                      ws->dirbingrids, lfsparms))){
       return(ret);
    }
 
-   /* Deallocate working memory. */
-   free_rotgrids(dirbingrids);
-
    /* Check dimension of binary image.  If they are different from */
    /* the input image, then ERROR.                                 */
    if((iw != bw) || (ih != bh)){
       /* Free memory allocated to this point. */
-      g_free(pdata);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
       g_free(bdata);
       fprintf(stderr, "ERROR : lfs_detect_minutiae_V2 :");
       fprintf(stderr,"binary image has bad dimensions : %d, %d\n",
@@ -305,6 +240,11 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
 
    time_accum(bin_timer, bin_time);
 
+   if(lfs_aborted(ws)){
+      g_free(bdata);
+      return(LFS_ABORTED);
+   }
+
    /******************/
    /*   DETECTION    */
    /******************/
@@ -316,6 +256,7 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
 
    /* Allocate initial list of minutia pointers. */
    if((ret = alloc_minutiae(&minutiae, MAX_MINUTIAE))){
+      g_free(bdata);
       return(ret);
    }
 
@@ -324,28 +265,25 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
                              direction_map, low_flow_map, high_curve_map,
                              mw, mh, lfsparms))){
       /* Free memory allocated to this point. */
-      g_free(pdata);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
       g_free(bdata);
+      free_minutiae(minutiae);
       return(ret);
    }
 
    time_accum(minutia_timer, minutia_time);
 
+   if(lfs_aborted(ws)){
+      g_free(bdata);
+      free_minutiae(minutiae);
+      return(LFS_ABORTED);
+   }
+
    set_timer(rm_minutia_timer);
 
    if((ret = remove_false_minutia_V2(minutiae, bdata, iw, ih,
                        direction_map, low_flow_map, high_curve_map, mw, mh,
                        lfsparms))){
       /* Free memory allocated to this point. */
-      g_free(pdata);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
       g_free(bdata);
       free_minutiae(minutiae);
       return(ret);
@@ -355,6 +293,12 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
 
    time_accum(rm_minutia_timer, rm_minutia_time);
 
+   if(lfs_aborted(ws)){
+      g_free(bdata);
+      free_minutiae(minutiae);
+      return(LFS_ABORTED);
+   }
+
    /******************/
    /*  RIDGE COUNTS  */
    /******************/
@@ -362,11 +306,7 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
 
    if((ret = count_minutiae_ridges(minutiae, bdata, iw, ih, lfsparms))){
       /* Free memory allocated to this point. */
-      g_free(pdata);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
+      g_free(bdata);
       free_minutiae(minutiae);
       return(ret);
    }
@@ -384,9 +324,6 @@ int lfs_detect_minutiae_V2(MINUTIAE **ominutiae,
    /* grayscale binary image [0,255].           */
    gray2bin(1, 255, 0, bdata, iw, ih);
 
-   /* Deallocate working memory. */
-   g_free(pdata);
-
    /* Assign results to output pointers. */
    *odmap = direction_map;
    *olcmap = low_contrast_map;
@@ -58,6 +58,7 @@ of the software.
                         free_dftwaves()
                         free_rotgrids()
                         free_dir_powers()
+                        free_workspace()
 ***********************************************************************/
 
 #include <stdio.h>
@@ -134,3 +135,40 @@ void free_dir_powers(double **powers, const int nwaves)
    g_free(powers);
 }
 
+/*************************************************************************
+**************************************************************************
+#cat: free_workspace - Deallocates the memory associated with a
+#cat:                  MINDTCT_WORKSPACE structure, including all lookup
+#cat:                  tables and buffers it still holds.
+
+   Input:
+      ws - pointer to memory to be freed
+**************************************************************************/
+void free_workspace(MINDTCT_WORKSPACE *ws)
+{
+   if(ws->dir2rad != NULL)
+      free_dir2rad(ws->dir2rad);
+   if(ws->dftwaves != NULL)
+      free_dftwaves(ws->dftwaves);
+   if(ws->dftgrids != NULL)
+      free_rotgrids(ws->dftgrids);
+   if(ws->dirbingrids != NULL)
+      free_rotgrids(ws->dirbingrids);
+
+   g_free(ws->pdata);
+
+   g_free(ws->direction_map);
+   g_free(ws->low_contrast_map);
+   g_free(ws->low_flow_map);
+   g_free(ws->high_curve_map);
+   g_free(ws->quality_map);
+
+   if(ws->powers != NULL)
+      free_dir_powers(ws->powers, ws->powers_nwaves);
+   g_free(ws->wis);
+   g_free(ws->powmaxs);
+   g_free(ws->powmax_dirs);
+   g_free(ws->pownorms);
+
+   g_free(ws);
+}
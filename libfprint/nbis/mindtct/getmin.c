@@ -78,6 +78,8 @@ of the software.
       id       - pixel depth (in bits) of the grayscale image
       ppmm     - the scan resolution (in pixels/mm) of the grayscale image
       lfsparms - parameters and thresholds for controlling LFS
+      ws       - workspace providing lookup tables and working memory,
+                 it may be reused for further calls
    Output:
       ominutiae         - points to a structure containing the
                           detected minutiae
@@ -86,6 +88,8 @@ of the software.
       olow_contrast_map - resulting low contrast map
       olow_flow_map     - resulting low ridge flow map
       ohigh_curve_map   - resulting high curvature map
+                          (all maps are owned by ws and only valid until
+                          it is used again or freed)
       omap_w   - width (in blocks) of image maps
       omap_h   - height (in blocks) of image maps
       obdata   - points to binarized image data
@@ -94,6 +98,7 @@ of the software.
       obd      - pixel depth (in bits) of binarized image
    Return Code:
       Zero     - successful completion
+      LFS_ABORTED - stopped by the abort callback of the workspace
       Negative - system error
 **************************************************************************/
 int get_minutiae(MINUTIAE **ominutiae, int **oquality_map,
@@ -102,7 +107,8 @@ int get_minutiae(MINUTIAE **ominutiae, int **oquality_map,
                  int *omap_w, int *omap_h,
                  unsigned char **obdata, int *obw, int *obh, int *obd,
                  unsigned char *idata, const int iw, const int ih,
-                 const int id, const double ppmm, const LFSPARMS *lfsparms)
+                 const int id, const double ppmm, const LFSPARMS *lfsparms,
+                 MINDTCT_WORKSPACE *ws)
 {
    int ret;
    MINUTIAE *minutiae;
@@ -125,19 +131,22 @@ int get_minutiae(MINUTIAE **ominutiae, int **oquality_map,
                                    &low_flow_map, &high_curve_map,
                                    &map_w, &map_h,
                                    &bdata, &bw, &bh,
-                                   idata, iw, ih, lfsparms))){
+                                   idata, iw, ih, lfsparms, ws))){
       return(ret);
    }
 
+   if(lfs_aborted(ws)){
+      free_minutiae(minutiae);
+      g_free(bdata);
+      return(LFS_ABORTED);
+   }
+
    /* Build integrated quality map. */
    if((ret = gen_quality_map(&quality_map,
                             direction_map, low_contrast_map,
-                            low_flow_map, high_curve_map, map_w, map_h))){
+                            low_flow_map, high_curve_map, map_w, map_h,
+                            ws))){
       free_minutiae(minutiae);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
       g_free(bdata);
       return(ret);
    }
@@ -147,11 +156,6 @@ int get_minutiae(MINUTIAE **ominutiae, int **oquality_map,
                                      lfsparms->blocksize,
                                      idata, iw, ih, id, ppmm))){
       free_minutiae(minutiae);
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      g_free(high_curve_map);
-      g_free(quality_map);
       g_free(bdata);
       return(ret);
    }
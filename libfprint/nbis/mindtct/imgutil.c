@@ -59,6 +59,7 @@ of the software.
                         bits_8to6()
                         gray2bin()
                         pad_uchar_image()
+                        copy_pad_uchar_image()
                         fill_holes()
                         free_path()
                         search_in_direction()
@@ -178,8 +179,8 @@ int pad_uchar_image(unsigned char **optr, int *ow, int *oh,
                     unsigned char *idata, const int iw, const int ih,
                     const int pad, const int pad_value)
 {
-   unsigned char *pdata, *pptr, *iptr;
-   int i, pw, ph;
+   unsigned char *pdata;
+   int pw, ph;
    int pad2, psize;
 
    /* Account for pad on both sides of image */
@@ -193,8 +194,42 @@ int pad_uchar_image(unsigned char **optr, int *ow, int *oh,
    /* Allocate padded image */
    pdata = (unsigned char *)g_malloc(psize * sizeof(unsigned char));
 
+   copy_pad_uchar_image(pdata, idata, iw, ih, pad, pad_value);
+
+   *optr = pdata;
+   *ow = pw;
+   *oh = ph;
+   return(0);
+}
+
+/*************************************************************************
+**************************************************************************
+#cat: copy_pad_uchar_image - Copies an 8-bit grayscale image into the
+#cat:                   center of a caller provided buffer and fills the
+#cat:                   surrounding pad area with a constant value.
+
+   Input:
+      idata     - input 8-bit grayscale image
+      iw        - width (in pixels) of the input image
+      ih        - height (in pixels) of the input image
+      pad       - size of padding (in pixels) to be added
+      pad_value - intensity of the padded area
+   Output:
+      pdata     - buffer of (iw+2*pad) x (ih+2*pad) pixels receiving the
+                  padded image
+**************************************************************************/
+void copy_pad_uchar_image(unsigned char *pdata, unsigned char *idata,
+                          const int iw, const int ih,
+                          const int pad, const int pad_value)
+{
+   unsigned char *pptr, *iptr;
+   int i, pw, ph;
+
+   pw = iw + (pad<<1);
+   ph = ih + (pad<<1);
+
    /* Initialize values to a constant PAD value */
-   memset(pdata, pad_value, psize);
+   memset(pdata, pad_value, pw * ph);
 
    /* Copy input image into padded image one scanline at a time */
    iptr = idata;
@@ -204,11 +239,6 @@ int pad_uchar_image(unsigned char **optr, int *ow, int *oh,
       iptr += iw;
       pptr += pw;
    }
-
-   *optr = pdata;
-   *ow = pw;
-   *oh = ph;
-   return(0);
 }
 
 /*************************************************************************
@@ -63,6 +63,11 @@ of the software.
                         init_rotgrids()
                         alloc_dir_powers()
                         alloc_power_stats()
+                        alloc_workspace()
+                        init_workspace_tables()
+                        alloc_workspace_image()
+                        alloc_workspace_maps()
+                        alloc_workspace_powers()
 ***********************************************************************/
 
 #include <stdio.h>
@@ -619,5 +624,217 @@ int alloc_power_stats(int **owis, double **opowmaxs, int **opowmax_dirs,
    return(0);
 }
 
+/*************************************************************************
+**************************************************************************
+#cat: alloc_workspace - Allocates an empty MINDTCT_WORKSPACE structure.
+#cat:             Lookup tables and buffers are allocated on first use.
+
+   Output:
+      ows - points to the allocated workspace
+   Return Code:
+      Zero     - successful completion
+      Negative - system error
+**************************************************************************/
+int alloc_workspace(MINDTCT_WORKSPACE **ows)
+{
+   *ows = (MINDTCT_WORKSPACE *)g_malloc0(sizeof(MINDTCT_WORKSPACE));
+   return(0);
+}
+
+/*************************************************************************
+**************************************************************************
+#cat: init_workspace_tables - Makes sure the lookup tables held by a
+#cat:             workspace match the given image dimensions and LFS
+#cat:             parameters.  Tables that are still valid are kept,
+#cat:             all others are rebuilt.
+
+   Input:
+      ws       - workspace holding the lookup tables
+      iw       - width (in pixels) of the unpadded input image
+      ih       - height (in pixels) of the unpadded input image
+      maxpad   - padding (in pixels) applied to the input image
+      lfsparms - parameters and thresholds for controlling LFS
+   Return Code:
+      Zero     - successful completion
+      Negative - system error
+**************************************************************************/
+int init_workspace_tables(MINDTCT_WORKSPACE *ws, const int iw, const int ih,
+                          const int maxpad, const LFSPARMS *lfsparms)
+{
+   int ret;
+   int grids_valid;
+
+   grids_valid = (ws->iw == iw) && (ws->ih == ih) && (ws->maxpad == maxpad) &&
+                 (ws->num_directions == lfsparms->num_directions) &&
+                 (ws->start_dir_angle == lfsparms->start_dir_angle);
+
+   if(ws->dir2rad != NULL &&
+      ws->num_directions != lfsparms->num_directions){
+      free_dir2rad(ws->dir2rad);
+      ws->dir2rad = NULL;
+   }
+   if(ws->dftwaves != NULL &&
+      (ws->num_dft_waves != lfsparms->num_dft_waves ||
+       ws->windowsize != lfsparms->windowsize)){
+      free_dftwaves(ws->dftwaves);
+      ws->dftwaves = NULL;
+   }
+   if(ws->dftgrids != NULL &&
+      (!grids_valid || ws->windowsize != lfsparms->windowsize)){
+      free_rotgrids(ws->dftgrids);
+      ws->dftgrids = NULL;
+   }
+   if(ws->dirbingrids != NULL &&
+      (!grids_valid || ws->dirbin_grid_w != lfsparms->dirbin_grid_w ||
+       ws->dirbin_grid_h != lfsparms->dirbin_grid_h)){
+      free_rotgrids(ws->dirbingrids);
+      ws->dirbingrids = NULL;
+   }
+
+   ws->iw = iw;
+   ws->ih = ih;
+   ws->maxpad = maxpad;
+   ws->num_directions = lfsparms->num_directions;
+   ws->start_dir_angle = lfsparms->start_dir_angle;
+   ws->num_dft_waves = lfsparms->num_dft_waves;
+   ws->windowsize = lfsparms->windowsize;
+   ws->dirbin_grid_w = lfsparms->dirbin_grid_w;
+   ws->dirbin_grid_h = lfsparms->dirbin_grid_h;
+
+   /* Lookup table for converting integer directions to radians. */
+   if(ws->dir2rad == NULL &&
+      (ret = init_dir2rad(&(ws->dir2rad), lfsparms->num_directions)))
+      return(ret);
+
+   /* Wave form lookup tables for DFT analyses. */
+   if(ws->dftwaves == NULL &&
+      (ret = init_dftwaves(&(ws->dftwaves), g_dft_coefs,
+                           lfsparms->num_dft_waves, lfsparms->windowsize)))
+      return(ret);
+
+   /* Pixel offsets to rotated grids used for DFT analyses. */
+   if(ws->dftgrids == NULL &&
+      (ret = init_rotgrids(&(ws->dftgrids), iw, ih, maxpad,
+                           lfsparms->start_dir_angle, lfsparms->num_directions,
+                           lfsparms->windowsize, lfsparms->windowsize,
+                           RELATIVE2ORIGIN)))
+      return(ret);
+
+   /* Pixel offsets to rotated grids used for directional binarization. */
+   if(ws->dirbingrids == NULL &&
+      (ret = init_rotgrids(&(ws->dirbingrids), iw, ih, maxpad,
+                           lfsparms->start_dir_angle, lfsparms->num_directions,
+                           lfsparms->dirbin_grid_w, lfsparms->dirbin_grid_h,
+                           RELATIVE2CENTER)))
+      return(ret);
+
+   return(0);
+}
 
+/*************************************************************************
+**************************************************************************
+#cat: alloc_workspace_image - Makes sure the padded image buffer of a
+#cat:             workspace can hold at least the given number of pixels.
 
+   Input:
+      ws    - workspace holding the buffer
+      psize - number of pixels in the padded image
+   Return Code:
+      Zero     - successful completion
+      Negative - system error
+**************************************************************************/
+int alloc_workspace_image(MINDTCT_WORKSPACE *ws, const int psize)
+{
+   if(psize > ws->pdata_alloc){
+      g_free(ws->pdata);
+      ws->pdata = (unsigned char *)g_malloc(psize * sizeof(unsigned char));
+      ws->pdata_alloc = psize;
+   }
+
+   return(0);
+}
+
+/*************************************************************************
+**************************************************************************
+#cat: alloc_workspace_maps - Makes sure the block maps of a workspace can
+#cat:             hold at least the given number of blocks.  The contents
+#cat:             of the maps are undefined afterwards.
+
+   Input:
+      ws      - workspace holding the maps
+      mapsize - number of blocks in each map
+   Return Code:
+      Zero     - successful completion
+      Negative - system error
+**************************************************************************/
+int alloc_workspace_maps(MINDTCT_WORKSPACE *ws, const int mapsize)
+{
+   if(mapsize <= ws->map_alloc)
+      return(0);
+
+   ASSERT_SIZE_MUL(mapsize, sizeof(int));
+
+   g_free(ws->direction_map);
+   g_free(ws->low_contrast_map);
+   g_free(ws->low_flow_map);
+   g_free(ws->high_curve_map);
+   g_free(ws->quality_map);
+
+   ws->direction_map = (int *)g_malloc(mapsize * sizeof(int));
+   ws->low_contrast_map = (int *)g_malloc(mapsize * sizeof(int));
+   ws->low_flow_map = (int *)g_malloc(mapsize * sizeof(int));
+   ws->high_curve_map = (int *)g_malloc(mapsize * sizeof(int));
+   ws->quality_map = (int *)g_malloc(mapsize * sizeof(int));
+   ws->map_alloc = mapsize;
+
+   return(0);
+}
+
+/*************************************************************************
+**************************************************************************
+#cat: alloc_workspace_powers - Makes sure a workspace holds DFT power
+#cat:             vectors and power statistics for the given number of
+#cat:             wave forms and directions.
+
+   Input:
+      ws     - workspace holding the vectors
+      nwaves - number of DFT wave forms
+      ndirs  - number of orientations (directions) used in DFT analysis
+   Return Code:
+      Zero     - successful completion
+      Negative - system error
+**************************************************************************/
+int alloc_workspace_powers(MINDTCT_WORKSPACE *ws, const int nwaves,
+                           const int ndirs)
+{
+   int ret;
+
+   if(ws->powers != NULL &&
+      ws->powers_nwaves == nwaves && ws->powers_ndirs == ndirs)
+      return(0);
+
+   if(ws->powers != NULL){
+      free_dir_powers(ws->powers, ws->powers_nwaves);
+      g_free(ws->wis);
+      g_free(ws->powmaxs);
+      g_free(ws->powmax_dirs);
+      g_free(ws->pownorms);
+      ws->powers = NULL;
+   }
+
+   if((ret = alloc_dir_powers(&(ws->powers), nwaves, ndirs)))
+      return(ret);
+
+   /* Statistics not needed for the first DFT wave. */
+   if((ret = alloc_power_stats(&(ws->wis), &(ws->powmaxs), &(ws->powmax_dirs),
+                               &(ws->pownorms), nwaves - 1))){
+      free_dir_powers(ws->powers, nwaves);
+      ws->powers = NULL;
+      return(ret);
+   }
+
+   ws->powers_nwaves = nwaves;
+   ws->powers_ndirs = ndirs;
+
+   return(0);
+}
@@ -120,36 +120,27 @@ of the software.
 int on_loop(const MINUTIA *minutia, const int max_loop_len,
             unsigned char *bdata, const int iw, const int ih)
 {
-   int ret;
-   int *contour_x, *contour_y, *contour_ex, *contour_ey, ncontour;
-
-   /* Trace the contour of the feature starting at the minutia point  */
-   /* and stepping along up to the specified maximum number of steps. */
-   ret = trace_contour(&contour_x, &contour_y,
-                       &contour_ex, &contour_ey, &ncontour, max_loop_len,
-                       minutia->x, minutia->y, minutia->x, minutia->y,
-                       minutia->ex, minutia->ey,
-                       SCAN_CLOCKWISE, bdata, iw, ih);
-
-   /* If trace was not possible ... */
-   if(ret == IGNORE)
-      return(ret);
-
-   /* If the trace completed a loop ... */
-   if(ret == LOOP_FOUND){
-      free_contour(contour_x, contour_y, contour_ex, contour_ey);
+   /* The contour points themselves are not needed, so rather than */
+   /* tracing (and storing) the contour, only walk along it.       */
+
+   /* If the feature and edge pixels are not opposite, the trace is  */
+   /* not possible.                                                   */
+   if(*(bdata+(minutia->y*iw)+minutia->x) ==
+      *(bdata+(minutia->ey*iw)+minutia->ex))
+      return(IGNORE);
+
+   /* Walk the contour of the feature starting at the minutia point */
+   /* and stepping along up to the specified maximum number of      */
+   /* steps, looking for the minutia point itself.                  */
+   if(search_contour(minutia->x, minutia->y, max_loop_len,
+                     minutia->x, minutia->y, minutia->ex, minutia->ey,
+                     SCAN_CLOCKWISE, bdata, iw, ih) == FOUND)
+      /* The walk completed a loop. */
       return(LOOP_FOUND);
-   }
-
-   /* If the trace successfully followed the minutia's contour, but did */
-   /* not complete a loop within the specified number of steps ...      */
-   if(ret == 0){
-      free_contour(contour_x, contour_y, contour_ex, contour_ey);
-      return(FALSE);
-   }
 
-   /* Otherwise, the trace had an error in following the contour ... */
-   return(ret);
+   /* Otherwise, the walk followed the minutia's contour, but did not */
+   /* complete a loop within the specified number of steps.           */
+   return(FALSE);
 }
 
 /*************************************************************************
@@ -327,74 +318,38 @@ int on_hook(const MINUTIA *minutia1, const MINUTIA *minutia2,
             const int max_hook_len,
             unsigned char *bdata, const int iw, const int ih)
 {
-   int ret;
-   int *contour_x, *contour_y, *contour_ex, *contour_ey, ncontour;
-
    /* NOTE: This routine should only be called when the 2 minutia points */
    /*       are of "opposite" type.                                      */
 
-   /* Trace the contour of the feature starting at the 1st minutia's     */
+   /* The contour points themselves are not needed, so rather than */
+   /* tracing (and storing) the contour, only walk along it.       */
+
+   /* If the feature and edge pixels are not opposite, the trace is */
+   /* not possible, so return IGNORE.                               */
+   if(*(bdata+(minutia1->ey*iw)+minutia1->ex) ==
+      *(bdata+(minutia1->y*iw)+minutia1->x))
+      return(IGNORE);
+
+   /* Walk the contour of the feature starting at the 1st minutia's      */
    /* "edge" point and stepping along up to the specified maximum number */
    /* of steps or until the 2nd minutia point is encountered.            */
    /* First search for edge neighbors clockwise.                         */
-
-   ret = trace_contour(&contour_x, &contour_y,
-                       &contour_ex, &contour_ey, &ncontour, max_hook_len,
-                       minutia2->x, minutia2->y, minutia1->ex, minutia1->ey,
-                       minutia1->x, minutia1->y,
-                       SCAN_CLOCKWISE, bdata, iw, ih);
-
-   /* If trace was not possible, return IGNORE. */
-   if(ret == IGNORE)
-      return(ret);
-
-   /* If the trace encountered the second minutia point ... */
-   if(ret == LOOP_FOUND){
-      free_contour(contour_x, contour_y, contour_ex, contour_ey);
+   if(search_contour(minutia2->x, minutia2->y, max_hook_len,
+                     minutia1->ex, minutia1->ey, minutia1->x, minutia1->y,
+                     SCAN_CLOCKWISE, bdata, iw, ih) == FOUND)
       return(HOOK_FOUND);
-   }
-
-   /* If trace had an error in following the contour ... */
-   if(ret != 0)
-      return(ret);
-
-
-   /* Otherwise, the trace successfully followed the contour, but did */
-   /* not encounter the 2nd minutia point within the specified number */
-   /* of steps.                                                       */
-
-   /* Deallocate previously extracted contour. */
-   free_contour(contour_x, contour_y, contour_ex, contour_ey);
 
    /* Try searching contour from 1st minutia "edge" searching for */
    /* edge neighbors counter-clockwise.                           */
-   ret = trace_contour(&contour_x, &contour_y,
-                       &contour_ex, &contour_ey, &ncontour, max_hook_len,
-                       minutia2->x, minutia2->y, minutia1->ex, minutia1->ey,
-                       minutia1->x, minutia1->y,
-                       SCAN_COUNTER_CLOCKWISE, bdata, iw, ih);
-
-   /* If trace was not possible, return IGNORE. */
-   if(ret == IGNORE)
-      return(ret);
-
-   /* If the trace encountered the second minutia point ... */
-   if(ret == LOOP_FOUND){
-      free_contour(contour_x, contour_y, contour_ex, contour_ey);
+   if(search_contour(minutia2->x, minutia2->y, max_hook_len,
+                     minutia1->ex, minutia1->ey, minutia1->x, minutia1->y,
+                     SCAN_COUNTER_CLOCKWISE, bdata, iw, ih) == FOUND)
       return(HOOK_FOUND);
-   }
 
-   /* If the trace successfully followed the 1st minutia's contour, but   */
-   /* did not encounter the 2nd minutia point within the specified number */
-   /* of steps ...      */
-   if(ret == 0){
-      free_contour(contour_x, contour_y, contour_ex, contour_ey);
-      /* Then return hook NOT found (FALSE). */
-      return(FALSE);
-   }
-
-   /* Otherwise, the 2nd trace had an error in following the contour ... */
-   return(ret);
+   /* The walks followed the 1st minutia's contour, but did not       */
+   /* encounter the 2nd minutia point within the specified number of  */
+   /* steps, so return hook NOT found (FALSE).                        */
+   return(FALSE);
 }
 
 /*************************************************************************
@@ -112,11 +112,12 @@ of the software.
       dftwaves  - structure containing the DFT wave forms
       dftgrids  - structure containing the rotated pixel grid offsets
       lfsparms  - parameters and thresholds for controlling LFS
+      ws        - workspace providing the map and DFT buffers
    Output:
-      odmap     - points to the created Direction Map
-      olcmap    - points to the created Low Contrast Map
-      olfmap    - points to the Low Ridge Flow Map
-      ohcmap    - points to the High Curvature Map
+      odmap     - points to the created Direction Map (owned by ws)
+      olcmap    - points to the created Low Contrast Map (owned by ws)
+      olfmap    - points to the Low Ridge Flow Map (owned by ws)
+      ohcmap    - points to the High Curvature Map (owned by ws)
       omw       - width (in blocks) of the maps
       omh       - height (in blocks) of the maps
    Return Code:
@@ -127,7 +128,8 @@ int gen_image_maps(int **odmap, int **olcmap, int **olfmap, int **ohcmap,
               int *omw, int *omh,
               unsigned char *pdata, const int pw, const int ph,
               const DIR2RAD *dir2rad, const DFTWAVES *dftwaves,
-              const ROTGRIDS *dftgrids, const LFSPARMS *lfsparms)
+              const ROTGRIDS *dftgrids, const LFSPARMS *lfsparms,
+              MINDTCT_WORKSPACE *ws)
 {
    int *direction_map, *low_contrast_map, *low_flow_map, *high_curve_map;
    int mw, mh, iw, ih;
@@ -152,16 +154,15 @@ int gen_image_maps(int **odmap, int **olcmap, int **olfmap, int **ohcmap,
    /* 2. Generate initial Direction Map and Low Contrast Map*/
    if((ret = gen_initial_maps(&direction_map, &low_contrast_map,
                               &low_flow_map, blkoffs, mw, mh,
-                              pdata, pw, ph, dftwaves, dftgrids, lfsparms))){
+                              pdata, pw, ph, dftwaves, dftgrids, lfsparms,
+                              ws))){
       /* Free memory allocated to this point. */
       g_free(blkoffs);
       return(ret);
    }
 
    if((ret = morph_TF_map(low_flow_map, mw, mh, lfsparms))){
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
+      g_free(blkoffs);
       return(ret);
    }
 
@@ -176,9 +177,7 @@ int gen_image_maps(int **odmap, int **olcmap, int **olfmap, int **ohcmap,
    /* 5. Interpolate INVALID direction blocks with their valid neighbors. */
    if((ret = interpolate_direction_map(direction_map, low_contrast_map,
                                        mw, mh, lfsparms))){
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
+      g_free(blkoffs);
       return(ret);
    }
 
@@ -197,10 +196,8 @@ int gen_image_maps(int **odmap, int **olcmap, int **olfmap, int **ohcmap,
 
    /* 9. Generate High Curvature Map from interpolated Direction Map. */
    if((ret = gen_high_curve_map(&high_curve_map, direction_map, mw, mh,
-                                lfsparms))){
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
+                                lfsparms, ws))){
+      g_free(blkoffs);
       return(ret);
    }
 
@@ -246,9 +243,11 @@ int gen_image_maps(int **odmap, int **olcmap, int **olfmap, int **ohcmap,
       dftwaves  - structure containing the DFT wave forms
       dftgrids  - structure containing the rotated pixel grid offsets
       lfsparms  - parameters and thresholds for controlling LFS
+      ws        - workspace providing the map and DFT buffers
    Output:
-      odmap     - points to the newly created Direction Map
-      olcmap    - points to the newly created Low Contrast Map
+      odmap     - points to the newly created Direction Map (owned by ws)
+      olcmap    - points to the newly created Low Contrast Map (owned by ws)
+      olfmap    - points to the newly created Low Flow Map (owned by ws)
    Return Code:
       Zero     - successful completion
       Negative - system error
@@ -257,7 +256,7 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
                 int *blkoffs, const int mw, const int mh,
                 unsigned char *pdata, const int pw, const int ph,
                 const DFTWAVES *dftwaves, const  ROTGRIDS *dftgrids,
-                const LFSPARMS *lfsparms)
+                const LFSPARMS *lfsparms, MINDTCT_WORKSPACE *ws)
 {
    int *direction_map, *low_contrast_map, *low_flow_map;
    int bi, bsize, blkdir;
@@ -275,43 +274,31 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
    ASSERT_INT_MUL(mw, mh);
    bsize = mw * mh;
 
-   /* Allocate Direction Map memory */
-   direction_map = (int *)g_malloc(bsize * sizeof(int));
+   /* Get map memory from the workspace */
+   if((ret = alloc_workspace_maps(ws, bsize)))
+      return(ret);
+   direction_map = ws->direction_map;
+   low_contrast_map = ws->low_contrast_map;
+   low_flow_map = ws->low_flow_map;
+
    /* Initialize the Direction Map to INVALID (-1). */
    memset(direction_map, INVALID_DIR, bsize * sizeof(int));
-
-   /* Allocate Low Contrast Map memory */
-   low_contrast_map = (int *)g_malloc(bsize * sizeof(int));
    /* Initialize the Low Contrast Map to FALSE (0). */
    memset(low_contrast_map, 0, bsize * sizeof(int));
-
-   /* Allocate Low Ridge Flow Map memory */
-   low_flow_map = (int *)g_malloc(bsize * sizeof(int));
    /* Initialize the Low Flow Map to FALSE (0). */
    memset(low_flow_map, 0, bsize * sizeof(int));
 
-   /* Allocate DFT directional power vectors */
-   if((ret = alloc_dir_powers(&powers, dftwaves->nwaves, dftgrids->ngrids))){
-      /* Free memory allocated to this point. */
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
+   /* Get DFT directional power vectors and power statistic arrays */
+   /* from the workspace.  Statistics not needed for the first DFT */
+   /* wave, so the length is number of waves - 1.                  */
+   if((ret = alloc_workspace_powers(ws, dftwaves->nwaves, dftgrids->ngrids)))
       return(ret);
-   }
-
-   /* Allocate DFT power statistic arrays */
-   /* Compute length of statistics arrays.  Statistics not needed   */
-   /* for the first DFT wave, so the length is number of waves - 1. */
+   powers = ws->powers;
+   wis = ws->wis;
+   powmaxs = ws->powmaxs;
+   powmax_dirs = ws->powmax_dirs;
+   pownorms = ws->pownorms;
    nstats = dftwaves->nwaves - 1;
-   if((ret = alloc_power_stats(&wis, &powmaxs, &powmax_dirs,
-                            &pownorms, nstats))){
-      /* Free memory allocated to this point. */
-      g_free(direction_map);
-      g_free(low_contrast_map);
-      g_free(low_flow_map);
-      free_dir_powers(powers, dftwaves->nwaves);
-      return(ret);
-   }
 
    /* Compute special window origin limits for determining low contrast.  */
    /* These pixel limits avoid analyzing the padded borders of the image. */
@@ -322,6 +309,11 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
 
    /* Foreach block in image ... */
    for(bi = 0; bi < bsize; bi++){
+      /* The DFT analyses dominate the map generation, so check for */
+      /* an abort at the start of each row of blocks.               */
+      if((bi % mw) == 0 && lfs_aborted(ws))
+         return(LFS_ABORTED);
+
       /* Adjust block offset from pointing to block origin to pointing */
       /* to surrounding window origin.                                 */
       dft_offset = blkoffs[bi] - (lfsparms->windowoffset * pw) -
@@ -346,14 +338,6 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
                                   pdata, pw, ph, lfsparms))){
          /* If system error ... */
          if(ret < 0){
-            g_free(direction_map);
-            g_free(low_contrast_map);
-            g_free(low_flow_map);
-            free_dir_powers(powers, dftwaves->nwaves);
-            g_free(wis);
-            g_free(powmaxs);
-            g_free(powmax_dirs);
-            g_free(pownorms);
             return(ret);
          }
 
@@ -369,15 +353,6 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
          /* Compute DFT powers */
          if((ret = dft_dir_powers(powers, pdata, low_contrast_offset, pw, ph,
                                dftwaves, dftgrids))){
-            /* Free memory allocated to this point. */
-            g_free(direction_map);
-            g_free(low_contrast_map);
-            g_free(low_flow_map);
-            free_dir_powers(powers, dftwaves->nwaves);
-            g_free(wis);
-            g_free(powmaxs);
-            g_free(powmax_dirs);
-            g_free(pownorms);
             return(ret);
          }
 
@@ -386,15 +361,6 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
          /* direction tests work below.                               */
          if((ret = dft_power_stats(wis, powmaxs, powmax_dirs, pownorms, powers,
                                 1, dftwaves->nwaves, dftgrids->ngrids))){
-            /* Free memory allocated to this point. */
-            g_free(direction_map);
-            g_free(low_contrast_map);
-            g_free(low_flow_map);
-            free_dir_powers(powers, dftwaves->nwaves);
-            g_free(wis);
-            g_free(powmaxs);
-            g_free(powmax_dirs);
-            g_free(pownorms);
             return(ret);
          }
 
@@ -432,13 +398,6 @@ int gen_initial_maps(int **odmap, int **olcmap, int **olfmap,
       } /* End DFT */
    } /* bi */
 
-   /* Deallocate working memory */
-   free_dir_powers(powers, dftwaves->nwaves);
-   g_free(wis);
-   g_free(powmaxs);
-   g_free(powmax_dirs);
-   g_free(pownorms);
-
    *odmap = direction_map;
    *olcmap = low_contrast_map;
    *olfmap = low_flow_map;
@@ -855,14 +814,16 @@ void smooth_direction_map(int *direction_map, int *low_contrast_map,
       mw        - the width (in blocks) of the map
       mh        - the height (in blocks) of the map
       lfsparms  - parameters and thresholds for controlling LFS
+      ws        - workspace providing the map buffer
    Output:
-      ohcmap    - points to the created High Curvature Map
+      ohcmap    - points to the created High Curvature Map (owned by ws)
    Return Code:
       Zero     - successful completion
       Negative - system error
 **************************************************************************/
 int gen_high_curve_map(int **ohcmap, int *direction_map,
-                   const int mw, const int mh, const LFSPARMS *lfsparms)
+                   const int mw, const int mh, const LFSPARMS *lfsparms,
+                   MINDTCT_WORKSPACE *ws)
 {
    int *high_curve_map, mapsize;
    int *hptr, *dptr;
@@ -872,9 +833,10 @@ int gen_high_curve_map(int **ohcmap, int *direction_map,
    ASSERT_INT_MUL(mw, mh);
    mapsize = mw*mh;
 
-   /* Allocate High Curvature Map. */
-   ASSERT_SIZE_MUL(mapsize, sizeof(int));
-   high_curve_map = (int *)g_malloc(mapsize * sizeof(int));
+   /* Get High Curvature Map from the workspace.  The maps were sized */
+   /* by gen_initial_maps(), so they must not be reallocated here.     */
+   g_assert(mapsize <= ws->map_alloc);
+   high_curve_map = ws->high_curve_map;
    /* Initialize High Curvature Map to FALSE (0). */
    memset(high_curve_map, 0, mapsize*sizeof(int));
 
@@ -98,15 +98,16 @@ of the software.
       high_curve_map   - map with blocks flagged as high curvature
       map_w            - width (in blocks) of the maps
       map_h            - height (in blocks) of the maps
+      ws               - workspace providing the map buffer
    Output:
-      oqmap      - points to new quality map
+      oqmap      - points to new quality map (owned by ws)
    Return Code:
       Zero       - successful completion
       Negative   - system error
 ************************************************************************/
 int gen_quality_map(int **oqmap, int *direction_map, int *low_contrast_map,
                     int *low_flow_map, int *high_curve_map,
-                    const int map_w, const int map_h)
+                    const int map_w, const int map_h, MINDTCT_WORKSPACE *ws)
 {
 
    int *QualMap;
@@ -118,7 +119,10 @@ int gen_quality_map(int **oqmap, int *direction_map, int *low_contrast_map,
    ASSERT_SIZE_MUL(map_w, map_h);
    ASSERT_SIZE_MUL(map_w * map_h, sizeof(int));
 
-   QualMap = (int *)g_malloc(map_w * map_h * sizeof(int));
+   /* The other maps live in the same workspace, so it is already */
+   /* large enough and must not be reallocated here.              */
+   g_assert(map_w * map_h <= ws->map_alloc);
+   QualMap = ws->quality_map;
 
    /* Foreach row of blocks in maps ... */
    for(thisY=0; thisY<map_h; thisY++){
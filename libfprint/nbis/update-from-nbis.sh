@@ -201,3 +201,12 @@ patch -p0 < remove-perimeter-pts.patch
 
 # Fix build on musl by dropping unnecessary redeclaration of stderr
 patch -p0 < fix-musl-build.patch
+
+# Keep lookup tables and working memory in a reusable workspace
+patch -p0 < reuse-workspace.patch
+
+# Recycle contour buffers and walk contours without storing them
+patch -p0 < recycle-contours.patch
+
+# Allow stopping the detection between processing steps
+patch -p0 < abort-detection.patch
@@ -383,6 +383,77 @@ test_context_remove_device_active (void)
   fpt_teardown_virtual_device_environment ();
 }
 
+static void
+context_identify_done_cb (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+  FptContext *tctx = user_data;
+  g_autoptr(FpDevice) device = NULL;
+  g_autoptr(FpPrint) match = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert_false (fp_context_identify_finish (FP_CONTEXT (source), res,
+                                              &device, &match, NULL, &error));
+  g_assert_nonnull (error);
+  g_assert_null (device);
+  g_assert_null (match);
+
+  tctx->user_data = g_steal_pointer (&error);
+}
+
+static void
+test_context_identify_no_devices (void)
+{
+  g_autoptr(FptContext) tctx = fpt_context_new ();
+  g_autoptr(GPtrArray) prints = g_ptr_array_new ();
+  g_autoptr(GError) error = NULL;
+
+  fp_context_identify (tctx->fp_context, prints, NULL, NULL, NULL, NULL,
+                       context_identify_done_cb, tctx);
+
+  while (!tctx->user_data)
+    g_main_context_iteration (NULL, TRUE);
+
+  error = tctx->user_data;
+  g_assert_error (error, FP_DEVICE_ERROR, FP_DEVICE_ERROR_NOT_SUPPORTED);
+}
+
+static void
+test_context_identify_cancel (void)
+{
+  g_autoptr(FptContext) tctx = fpt_context_new_with_virtual_device (FPT_VIRTUAL_DEVICE_IMAGE);
+  g_autoptr(GPtrArray) prints = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+  g_autoptr(GError) error = NULL;
+
+  fp_device_open_sync (tctx->device, NULL, &error);
+  g_assert_no_error (error);
+
+  g_ptr_array_add (prints, fp_print_new (tctx->device));
+
+  tctx->user_data = NULL;
+  fp_context_identify (tctx->fp_context, prints, cancellable, NULL, NULL, NULL,
+                       context_identify_done_cb, tctx);
+
+  /* Device is busy identifying now */
+  while (g_main_context_iteration (NULL, FALSE))
+    {
+    }
+  g_assert_null (tctx->user_data);
+
+  g_cancellable_cancel (cancellable);
+  while (!tctx->user_data)
+    g_main_context_iteration (NULL, TRUE);
+
+  error = tctx->user_data;
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&error);
+
+  fp_device_close_sync (tctx->device, NULL, &error);
+  g_assert_no_error (error);
+
+  fpt_teardown_virtual_device_environment ();
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -397,6 +468,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/context/remove-device-open", test_context_remove_device_open);
   g_test_add_func ("/context/remove-device-opening", test_context_remove_device_opening);
   g_test_add_func ("/context/remove-device-active", test_context_remove_device_active);
+  g_test_add_func ("/context/identify/no-devices", test_context_identify_no_devices);
+  g_test_add_func ("/context/identify/cancel", test_context_identify_cancel);
 
   return g_test_run ();
 }
@@ -0,0 +1,111 @@
+/*
+ * Unit tests for libfprint background subtraction helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+#include "fpi-background.h"
+
+#define N_PIXELS 1031
+
+static void
+test_background_u8 (void)
+{
+  g_autofree guint8 *background = g_malloc (N_PIXELS);
+  g_autofree guint8 *frame = g_malloc (N_PIXELS);
+  g_autofree guint8 *expected = g_malloc (N_PIXELS);
+  guint64 expected_energy = 0;
+  gsize i;
+
+  memset (background, 255, N_PIXELS);
+  for (i = 0; i < N_PIXELS; i++)
+    frame[i] = g_test_rand_int_range (0, 256);
+  fpi_background_update_min_u8 (background, frame, N_PIXELS);
+  g_assert_cmpmem (background, N_PIXELS, frame, N_PIXELS);
+
+  for (i = 0; i < N_PIXELS; i++)
+    {
+      frame[i] = g_test_rand_int_range (0, 256);
+
+      if (frame[i] - 3 > background[i])
+        expected[i] = frame[i] - background[i];
+      else
+        expected[i] = 0;
+      expected_energy += expected[i];
+    }
+
+  g_assert_cmpuint (fpi_background_subtract_u8 (frame, background, N_PIXELS, 3),
+                    ==, expected_energy);
+  g_assert_cmpmem (frame, N_PIXELS, expected, N_PIXELS);
+}
+
+static void
+test_background_u16 (void)
+{
+  /* Large enough to span multiple blocks of the sum */
+  gsize n_pixels = 3 * 65536 + 17;
+  g_autofree guint16 *background = g_new (guint16, n_pixels);
+  g_autofree guint16 *frame = g_new (guint16, n_pixels);
+  guint64 expected_energy = 0;
+  guint64 expected_sum = 0;
+  gsize i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      background[i] = g_test_rand_int_range (0, 1024);
+      frame[i] = i % 2 ? 0xffff : g_test_rand_int_range (0, 1024);
+      expected_sum += background[i];
+      if (frame[i] > background[i])
+        expected_energy += frame[i] - background[i];
+    }
+
+  g_assert_cmpuint (fpi_background_sum_u16 (background, n_pixels), ==, expected_sum);
+  g_assert_cmpuint (fpi_background_subtract_u16 (frame, background, n_pixels, 0),
+                    ==, expected_energy);
+
+  for (i = 0; i < n_pixels; i += 2)
+    g_assert_cmpuint (frame[i], <, 1024);
+}
+
+static void
+test_background_clamp (void)
+{
+  guint8 pixels[] = { 0, 100, 144, 145, 200, 255 };
+  guint8 expected[] = { 0, 100, 144, 255, 255, 255 };
+
+  fpi_background_clamp_u8 (pixels, G_N_ELEMENTS (pixels), 144);
+  g_assert_cmpmem (pixels, sizeof (pixels), expected, sizeof (expected));
+}
+
+static void
+test_background_finger_present (void)
+{
+  g_assert_false (fpi_background_finger_present (20 * 100, 100, 20));
+  g_assert_true (fpi_background_finger_present (21 * 100, 100, 20));
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/background/u8", test_background_u8);
+  g_test_add_func ("/background/u16", test_background_u16);
+  g_test_add_func ("/background/clamp", test_background_clamp);
+  g_test_add_func ("/background/finger_present", test_background_finger_present);
+
+  return g_test_run ();
+}
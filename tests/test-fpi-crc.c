@@ -0,0 +1,160 @@
+/*
+ * Unit tests for libfprint CRC helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+#include "fpi-crc.h"
+
+static const guint8 check_data[] = "123456789";
+
+typedef struct
+{
+  const char *name;
+  FpiCrc      crc;
+  guint32     check;
+} CrcTestCase;
+
+static CrcTestCase test_cases[] = {
+  { "CRC-8/SMBUS", FPI_CRC_INIT (8, 0x07, 0x00, 0x00, FALSE), 0xF4 },
+  { "CRC-8/MAXIM-DOW", FPI_CRC_INIT (8, 0x31, 0x00, 0x00, TRUE), 0xA1 },
+  { "CRC-16/XMODEM", FPI_CRC_INIT (16, 0x1021, 0x0000, 0x0000, FALSE), 0x31C3 },
+  { "CRC-16/IBM-3740", FPI_CRC_INIT (16, 0x1021, 0xFFFF, 0x0000, FALSE), 0x29B1 },
+  { "CRC-16/ARC", FPI_CRC_INIT (16, 0x8005, 0x0000, 0x0000, TRUE), 0xBB3D },
+  { "CRC-32/ISO-HDLC", FPI_CRC_INIT (32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, TRUE), 0xCBF43926 },
+  { "CRC-32/BZIP2", FPI_CRC_INIT (32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, FALSE), 0xFC891918 },
+  { "CRC-32/MPEG-2", FPI_CRC_INIT (32, 0x04C11DB7, 0xFFFFFFFF, 0x00000000, FALSE), 0x0376E6E7 },
+};
+
+/* Plain bit by bit implementation of the Rocksoft model */
+static guint32
+reference_crc (const FpiCrc *crc, const guint8 *data, gsize len)
+{
+  guint32 top = 1u << (crc->width - 1);
+  guint32 mask = crc->width == 32 ? 0xFFFFFFFF : (1u << crc->width) - 1;
+  guint32 reg = crc->init;
+  gsize i;
+  int bit;
+
+  for (i = 0; i < len; i++)
+    {
+      for (bit = 0; bit < 8; bit++)
+        {
+          gboolean in;
+
+          if (crc->reflected)
+            in = (data[i] >> bit) & 1;
+          else
+            in = (data[i] >> (7 - bit)) & 1;
+
+          if (!!(reg & top) != in)
+            reg = ((reg << 1) ^ crc->poly) & mask;
+          else
+            reg = (reg << 1) & mask;
+        }
+    }
+
+  if (crc->reflected)
+    {
+      guint32 res = 0;
+
+      for (bit = 0; bit < crc->width; bit++)
+        if (reg & (1u << bit))
+          res |= 1u << (crc->width - 1 - bit);
+      reg = res;
+    }
+
+  return reg ^ crc->xorout;
+}
+
+static void
+test_crc_check_values (void)
+{
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (test_cases); i++)
+    {
+      CrcTestCase *tc = &test_cases[i];
+
+      g_test_message ("Checking %s", tc->name);
+      g_assert_cmphex (fpi_crc_compute (&tc->crc, check_data, sizeof (check_data) - 1),
+                       ==, tc->check);
+    }
+}
+
+static void
+test_crc_random_data (void)
+{
+  g_autofree guint8 *data = NULL;
+  gsize data_len = 1027;
+  gsize i, len;
+
+  data = g_malloc (data_len);
+  for (i = 0; i < data_len; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+
+  for (i = 0; i < G_N_ELEMENTS (test_cases); i++)
+    {
+      CrcTestCase *tc = &test_cases[i];
+
+      /* Cover all tail lengths and unaligned starting points */
+      for (len = 0; len < 40; len++)
+        g_assert_cmphex (fpi_crc_compute (&tc->crc, data + len % 8, len),
+                         ==, reference_crc (&tc->crc, data + len % 8, len));
+
+      g_assert_cmphex (fpi_crc_compute (&tc->crc, data, data_len),
+                       ==, reference_crc (&tc->crc, data, data_len));
+    }
+}
+
+static void
+test_crc_incremental (void)
+{
+  g_autofree guint8 *data = NULL;
+  gsize data_len = 523;
+  gsize i, split;
+
+  data = g_malloc (data_len);
+  for (i = 0; i < data_len; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+
+  for (i = 0; i < G_N_ELEMENTS (test_cases); i++)
+    {
+      CrcTestCase *tc = &test_cases[i];
+      guint32 expected = fpi_crc_compute (&tc->crc, data, data_len);
+
+      for (split = 0; split < data_len; split += 37)
+        {
+          guint32 state = fpi_crc_start (&tc->crc);
+
+          state = fpi_crc_update (&tc->crc, state, data, split);
+          state = fpi_crc_update (&tc->crc, state, data + split, data_len - split);
+          g_assert_cmphex (fpi_crc_finish (&tc->crc, state), ==, expected);
+        }
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/crc/check_values", test_crc_check_values);
+  g_test_add_func ("/crc/random_data", test_crc_random_data);
+  g_test_add_func ("/crc/incremental", test_crc_incremental);
+
+  return g_test_run ();
+}
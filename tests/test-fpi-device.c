@@ -26,6 +26,7 @@
 #include "fpi-device.h"
 #include "fpi-compat.h"
 #include "fpi-log.h"
+#include "fpi-metrics.h"
 #include "test-device-fake.h"
 #include "fp-print-private.h"
 
@@ -533,6 +534,53 @@ test_driver_get_driver_data (void)
   g_assert_cmpuint (fpi_device_get_driver_data (device), ==, driver_data);
 }
 
+static void
+test_driver_calibration (void)
+{
+  g_autoptr(FpDevice) device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  g_autoptr(FpDevice) other_device = NULL;
+  g_autoptr(GBytes) data = g_bytes_new_static ("calibration", 11);
+  g_autoptr(GBytes) cached = NULL;
+  g_autoptr(GVariant) saved = NULL;
+  g_autoptr(GVariant) broken = g_variant_ref_sink (g_variant_new_string ("broken"));
+  g_autoptr(GError) error = NULL;
+
+  g_assert_null (fp_device_get_calibration_data (device));
+  g_assert_null (fpi_device_get_calibration (device, "sensor-1", -1));
+
+  fpi_device_set_calibration (device, "sensor-1", data);
+
+  cached = fpi_device_get_calibration (device, "sensor-1", -1);
+  g_assert_true (g_bytes_equal (cached, data));
+  g_clear_pointer (&cached, g_bytes_unref);
+
+  cached = fpi_device_get_calibration (device, "sensor-1", 60);
+  g_assert_true (g_bytes_equal (cached, data));
+  g_clear_pointer (&cached, g_bytes_unref);
+
+  g_assert_null (fpi_device_get_calibration (device, "sensor-2", -1));
+
+  /* Restore into a fresh device object, as after a restart */
+  saved = fp_device_get_calibration_data (device);
+  g_assert_nonnull (saved);
+
+  other_device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  g_assert_true (fp_device_set_calibration_data (other_device, saved, &error));
+  g_assert_no_error (error);
+
+  cached = fpi_device_get_calibration (other_device, "sensor-1", 60);
+  g_assert_true (g_bytes_equal (cached, data));
+  g_clear_pointer (&cached, g_bytes_unref);
+
+  g_assert_false (fp_device_set_calibration_data (other_device, broken, &error));
+  g_assert_error (error, FP_DEVICE_ERROR, FP_DEVICE_ERROR_DATA_INVALID);
+  g_clear_error (&error);
+
+  fpi_device_clear_calibration (device);
+  g_assert_null (fp_device_get_calibration_data (device));
+  g_assert_null (fpi_device_get_calibration (device, "sensor-1", -1));
+}
+
 static void
 test_driver_features_probe_updates (void)
 {
@@ -2412,6 +2460,181 @@ test_driver_identify_warmup_cooldown (void)
   g_assert_cmpint (g_get_monotonic_time () - start_time, <, 5000000 + 500000);
 }
 
+static void
+fake_device_record_identify (FpDevice *device)
+{
+  FpiDeviceFake *fake_dev = FPI_DEVICE_FAKE (device);
+
+  fake_dev->last_called_function = fake_device_record_identify;
+}
+
+static void
+test_driver_identify_throttle (void)
+{
+  g_autoptr(FpAutoResetClass) dev_class = auto_reset_device_class ();
+  g_autoptr(MatchCbData) identify_data = g_new0 (MatchCbData, 1);
+  g_autoptr(MatchCbData) throttled_data = g_new0 (MatchCbData, 1);
+  g_autoptr(GPtrArray) prints = NULL;
+  g_autoptr(FpAutoCloseDevice) device = NULL;
+  void (*orig_identify) (FpDevice *device);
+  FpiDeviceFake *fake_dev;
+  gint64 start_time;
+  gint budget;
+
+  dev_class->temp_hot_seconds = 2;
+  dev_class->temp_cold_seconds = 5;
+
+  device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  fake_dev = FPI_DEVICE_FAKE (device);
+  orig_identify = dev_class->identify;
+  dev_class->identify = fake_device_record_identify;
+
+  prints = make_fake_prints_gallery (device, 1);
+
+  g_assert_true (fp_device_open_sync (device, NULL, NULL));
+  g_assert_cmpint (fp_device_get_duty_budget (device), >, 1900);
+
+  /* Keep the device active for one second */
+  fake_dev->ret_error = fpi_device_error_new (FP_DEVICE_ERROR_GENERAL);
+  fp_device_identify (device, prints, NULL, NULL, NULL, NULL,
+                      (GAsyncReadyCallback) test_driver_identify_cb, identify_data);
+  g_assert (fake_dev->last_called_function == fake_device_record_identify);
+
+  start_time = g_get_monotonic_time ();
+  while (g_get_monotonic_time () - start_time < 1000000)
+    g_main_context_iteration (NULL, FALSE);
+
+  orig_identify (device);
+  fake_dev->ret_error = NULL;
+  while (!identify_data->called)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_error (identify_data->error, FP_DEVICE_ERROR, FP_DEVICE_ERROR_GENERAL);
+
+  /* About one second left, which is not enough for another such identify */
+  budget = fp_device_get_duty_budget (device);
+  g_assert_cmpint (budget, >, 800);
+  g_assert_cmpint (budget, <, 1200);
+  g_assert_cmpint (fp_device_get_temperature (device), !=, FP_TEMPERATURE_HOT);
+
+  /* So the next one is delayed instead of failing once the device is hot */
+  fake_dev->last_called_function = NULL;
+  fake_dev->ret_error = fpi_device_error_new (FP_DEVICE_ERROR_GENERAL);
+  fp_device_identify (device, prints, NULL, NULL, NULL, NULL,
+                      (GAsyncReadyCallback) test_driver_identify_cb, throttled_data);
+  g_assert_null (fake_dev->last_called_function);
+
+  start_time = g_get_monotonic_time ();
+  while (fake_dev->last_called_function == NULL)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpint (g_get_monotonic_time () - start_time, >, 300000);
+  g_assert_cmpint (g_get_monotonic_time () - start_time, <, 1000000);
+
+  /* Device cooled down enough to fit the estimated active time */
+  g_assert_cmpint (fp_device_get_duty_budget (device), >, 1000);
+
+  orig_identify (device);
+  fake_dev->ret_error = NULL;
+  while (!throttled_data->called)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_error (throttled_data->error, FP_DEVICE_ERROR, FP_DEVICE_ERROR_GENERAL);
+}
+
+static gdouble
+lookup_metric (GVariant   *samples,
+               const char *name,
+               const char *label,
+               const char *label_value)
+{
+  GVariantIter iter;
+  GVariant *labels;
+  const char *sample_name;
+  gdouble value;
+
+  g_variant_iter_init (&iter, samples);
+  while (g_variant_iter_next (&iter, "(&s@a{ss}d)", &sample_name, &labels, &value))
+    {
+      g_autoptr(GVariant) sample_labels = labels;
+      g_autoptr(GVariantDict) dict = g_variant_dict_new (sample_labels);
+      const char *found_value = NULL;
+
+      if (!g_str_equal (sample_name, name))
+        continue;
+
+      g_assert_true (g_variant_dict_contains (dict, "driver"));
+      g_assert_true (g_variant_dict_contains (dict, "device"));
+
+      if (label && (!g_variant_dict_lookup (dict, label, "&s", &found_value) ||
+                    !g_str_equal (found_value, label_value)))
+        continue;
+
+      return value;
+    }
+
+  g_assert_not_reached ();
+}
+
+static void
+test_driver_identify_metrics (void)
+{
+  g_autoptr(FpAutoCloseDevice) device = auto_close_fake_device_new ();
+  g_autoptr(GPtrArray) prints = make_fake_prints_gallery (device, 10);
+  g_autoptr(GVariant) samples = NULL;
+  FpiDeviceFake *fake_dev = FPI_DEVICE_FAKE (device);
+  GVariantBuilder builder;
+  gint i;
+
+  fp_print_set_description (g_ptr_array_index (prints, 3), "fake-verified");
+
+  for (i = 0; i < 3; i++)
+    {
+      g_autoptr(FpPrint) match = NULL;
+      g_autoptr(FpPrint) print = NULL;
+      g_autoptr(GError) error = NULL;
+
+      if (i == 1)
+        {
+          g_ptr_array_remove_index (prints, 3);
+        }
+      else if (i == 2)
+        {
+          fake_dev->ret_print = NULL;
+          fake_dev->ret_error = fpi_device_retry_new (FP_DEVICE_RETRY_TOO_SHORT);
+          g_assert_false (fp_device_identify_sync (device, prints, NULL, NULL, NULL,
+                                                   &match, &print, &error));
+          g_assert_error (error, FP_DEVICE_RETRY, FP_DEVICE_RETRY_TOO_SHORT);
+          g_assert (error == g_steal_pointer (&fake_dev->ret_error));
+          continue;
+        }
+
+      fake_dev->ret_print = make_fake_print (device, NULL);
+      g_assert_true (fp_device_identify_sync (device, prints, NULL, NULL, NULL,
+                                              &match, &print, &error));
+      g_assert_no_error (error);
+    }
+
+  fpi_device_metrics_observe (device, FPI_METRIC_MINUTIAE, 3);
+  fpi_device_metrics_observe (device, FPI_METRIC_MINUTIAE, 40);
+  fpi_device_metrics_observe (device, FPI_METRIC_MINUTIAE, 1000000000);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sa{ss}d)"));
+  fpi_device_metrics_append_samples (device, &builder);
+  samples = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_scans_total", NULL, NULL), ==, 3);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_match_results_total", "result", "match"), ==, 1);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_match_results_total", "result", "no-match"), ==, 1);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_retries_total", "reason", "too-short"), ==, 1);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_retries_total", "reason", "general"), ==, 0);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_usb_bytes_total", "direction", "in"), ==, 0);
+
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_minutiae_bucket", "le", "2"), ==, 0);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_minutiae_bucket", "le", "4"), ==, 1);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_minutiae_bucket", "le", "64"), ==, 2);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_minutiae_bucket", "le", "+Inf"), ==, 3);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_minutiae_count", NULL, NULL), ==, 3);
+  g_assert_cmpfloat (lookup_metric (samples, "fprint_minutiae_sum", NULL, NULL), ==, 1000000043);
+}
+
 static void
 fake_device_stub_capture (FpDevice *device)
 {
@@ -3329,6 +3552,143 @@ test_driver_add_timeout_cancelled (void)
   g_assert_null (fake_dev->last_called_function);
 }
 
+static void
+test_driver_add_timer (void)
+{
+  g_autoptr(FpDevice) device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  FpiDeviceFake *fake_dev = FPI_DEVICE_FAKE (device);
+  FpDevice *data_check = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  guint id;
+
+  g_object_add_weak_pointer (G_OBJECT (data_check), (gpointer) & data_check);
+  id = fpi_device_add_timer (device, 50, test_driver_add_timeout_func,
+                             data_check, g_object_unref);
+
+  g_assert_cmpuint (id, !=, 0);
+  g_assert_nonnull (data_check);
+
+  while (FP_IS_DEVICE (data_check))
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_null (data_check);
+  g_assert (fake_dev->last_called_function == test_driver_add_timeout_func);
+
+  /* Already ran, so it cannot be removed anymore */
+  g_assert_false (fpi_device_remove_timer (device, id));
+}
+
+static gboolean
+test_driver_add_timer_cancelled_timeout (gpointer data)
+{
+  gboolean *timeout_reached = data;
+
+  *timeout_reached = TRUE;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+test_driver_add_timer_cancelled (void)
+{
+  g_autoptr(FpDevice) device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  FpiDeviceFake *fake_dev = FPI_DEVICE_FAKE (device);
+  FpDevice *data_check = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  gboolean timeout_reached = FALSE;
+  guint id;
+
+  g_object_add_weak_pointer (G_OBJECT (data_check), (gpointer) & data_check);
+  id = fpi_device_add_timer (device, 20, test_driver_add_timeout_func,
+                             data_check, g_object_unref);
+
+  g_assert_true (fpi_device_remove_timer (device, id));
+  g_assert_null (data_check);
+  g_assert_false (fpi_device_remove_timer (device, id));
+
+  g_timeout_add (50, test_driver_add_timer_cancelled_timeout, &timeout_reached);
+  while (!timeout_reached)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_null (fake_dev->last_called_function);
+}
+
+static void
+test_driver_add_timer_order_func (FpDevice *device, gpointer user_data)
+{
+  GArray *order = g_object_get_data (G_OBJECT (device), "timer-order");
+  int value = GPOINTER_TO_INT (user_data);
+
+  g_array_append_val (order, value);
+}
+
+static void
+test_driver_add_timer_order (void)
+{
+  g_autoptr(FpDevice) device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  g_autoptr(GArray) order = g_array_new (FALSE, FALSE, sizeof (int));
+  guint removed;
+
+  g_object_set_data (G_OBJECT (device), "timer-order", order);
+
+  fpi_device_add_timer (device, 60, test_driver_add_timer_order_func,
+                        GINT_TO_POINTER (4), NULL);
+  fpi_device_add_timer (device, 10, test_driver_add_timer_order_func,
+                        GINT_TO_POINTER (1), NULL);
+  removed = fpi_device_add_timer (device, 20, test_driver_add_timer_order_func,
+                                  GINT_TO_POINTER (-1), NULL);
+  fpi_device_add_timer (device, 30, test_driver_add_timer_order_func,
+                        GINT_TO_POINTER (2), NULL);
+  fpi_device_add_timer (device, 30, test_driver_add_timer_order_func,
+                        GINT_TO_POINTER (3), NULL);
+
+  g_assert_true (fpi_device_remove_timer (device, removed));
+
+  while (order->len < 4)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpint (g_array_index (order, int, 0), ==, 1);
+  g_assert_cmpint (g_array_index (order, int, 1), ==, 2);
+  g_assert_cmpint (g_array_index (order, int, 2), ==, 3);
+  g_assert_cmpint (g_array_index (order, int, 3), ==, 4);
+}
+
+static void
+test_driver_add_timer_context_func (FpDevice *device, gpointer user_data)
+{
+  GMainContext **ran_in = user_data;
+
+  *ran_in = g_main_context_ref_thread_default ();
+}
+
+static void
+test_driver_add_timer_contexts (void)
+{
+  g_autoptr(FpDevice) device = g_object_new (FPI_TYPE_DEVICE_FAKE, NULL);
+  g_autoptr(GMainContext) context = g_main_context_new ();
+  g_autoptr(GMainContext) default_ran_in = NULL;
+  g_autoptr(GMainContext) context_ran_in = NULL;
+
+  fpi_device_add_timer (device, 0, test_driver_add_timer_context_func,
+                        &default_ran_in, NULL);
+
+  /* A timer added while another context is the thread default has to be
+   * dispatched from that context, even with a timer pending elsewhere. */
+  g_main_context_push_thread_default (context);
+  fpi_device_add_timer (device, 0, test_driver_add_timer_context_func,
+                        &context_ran_in, NULL);
+
+  while (!context_ran_in)
+    g_main_context_iteration (context, TRUE);
+
+  g_assert (context_ran_in == context);
+  g_assert_null (default_ran_in);
+  g_main_context_pop_thread_default (context);
+
+  while (!default_ran_in)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert (default_ran_in == g_main_context_default ());
+}
+
 static void
 test_driver_error_types (void)
 {
@@ -3415,6 +3775,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/driver/get_usb_device", test_driver_get_usb_device);
   g_test_add_func ("/driver/get_virtual_env", test_driver_get_virtual_env);
   g_test_add_func ("/driver/get_driver_data", test_driver_get_driver_data);
+  g_test_add_func ("/driver/calibration", test_driver_calibration);
   g_test_add_func ("/driver/features/probe_updates", test_driver_features_probe_updates);
   g_test_add_func ("/driver/initial_features", test_driver_initial_features);
   g_test_add_func ("/driver/initial_features/none", test_driver_initial_features_none);
@@ -3467,6 +3828,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/driver/identify/suspend_while_idle", test_driver_identify_suspend_while_idle);
 
   g_test_add_func ("/driver/identify/warmup_cooldown", test_driver_identify_warmup_cooldown);
+  g_test_add_func ("/driver/identify/throttle", test_driver_identify_throttle);
+  g_test_add_func ("/driver/identify/metrics", test_driver_identify_metrics);
 
   g_test_add_func ("/driver/capture", test_driver_capture);
   g_test_add_func ("/driver/capture/not_supported", test_driver_capture_not_supported);
@@ -3498,6 +3861,10 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/driver/timeout", test_driver_add_timeout);
   g_test_add_func ("/driver/timeout/cancelled", test_driver_add_timeout_cancelled);
+  g_test_add_func ("/driver/timer", test_driver_add_timer);
+  g_test_add_func ("/driver/timer/cancelled", test_driver_add_timer_cancelled);
+  g_test_add_func ("/driver/timer/order", test_driver_add_timer_order);
+  g_test_add_func ("/driver/timer/contexts", test_driver_add_timer_contexts);
 
   g_test_add_func ("/driver/error_types", test_driver_error_types);
   g_test_add_func ("/driver/retry_error_types", test_driver_retry_error_types);
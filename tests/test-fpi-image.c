@@ -0,0 +1,126 @@
+/*
+ * Unit tests for libfprint image helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <nbis.h>
+
+#include "fpi-image.h"
+
+static void
+assert_lfsparms_default (const LFSPARMS *lfsparms)
+{
+  g_assert_cmpint (lfsparms->blocksize, ==, g_lfsparms_V2.blocksize);
+  g_assert_cmpint (lfsparms->windowsize, ==, g_lfsparms_V2.windowsize);
+  g_assert_cmpint (lfsparms->windowoffset, ==, g_lfsparms_V2.windowoffset);
+  g_assert_cmpint (lfsparms->trans_dir_pix, ==, g_lfsparms_V2.trans_dir_pix);
+  g_assert_cmpint (lfsparms->inv_block_margin, ==, g_lfsparms_V2.inv_block_margin);
+  g_assert_cmpint (lfsparms->num_dft_waves, ==, g_lfsparms_V2.num_dft_waves);
+  g_assert_cmpint (lfsparms->num_directions, ==, g_lfsparms_V2.num_directions);
+  g_assert_cmpint (lfsparms->remove_perimeter_pts, ==, g_lfsparms_V2.remove_perimeter_pts);
+}
+
+static void
+test_minutiae_profile_default (void)
+{
+  FpiMinutiaeProfile empty = { 0 };
+  LFSPARMS lfsparms;
+
+  memset (&lfsparms, 0xff, sizeof (lfsparms));
+  g_assert_true (fpi_minutiae_profile_to_lfsparms (NULL, &lfsparms));
+  assert_lfsparms_default (&lfsparms);
+
+  /* An empty profile derives the defaults from themselves */
+  memset (&lfsparms, 0xff, sizeof (lfsparms));
+  g_assert_true (fpi_minutiae_profile_to_lfsparms (&empty, &lfsparms));
+  assert_lfsparms_default (&lfsparms);
+}
+
+static void
+test_minutiae_profile_full (void)
+{
+  FpiMinutiaeProfile profile = { .blocksize = 16, .windowsize = 32 };
+  LFSPARMS lfsparms;
+
+  g_assert_true (fpi_minutiae_profile_to_lfsparms (&profile, &lfsparms));
+  g_assert_cmpint (lfsparms.blocksize, ==, 16);
+  g_assert_cmpint (lfsparms.windowsize, ==, 32);
+  g_assert_cmpint (lfsparms.windowoffset, ==, 8);
+  g_assert_cmpint (lfsparms.trans_dir_pix, ==, 8);
+  g_assert_cmpint (lfsparms.inv_block_margin, ==, 8);
+  g_assert_cmpint (lfsparms.num_dft_waves, ==, g_lfsparms_V2.num_dft_waves);
+  g_assert_cmpint (lfsparms.num_directions, ==, g_lfsparms_V2.num_directions);
+}
+
+static void
+test_minutiae_profile_partial (void)
+{
+  FpiMinutiaeProfile blocksize_only = { .blocksize = 12 };
+  FpiMinutiaeProfile waves_only = { .num_dft_waves = 3 };
+  FpiMinutiaeProfile waves_clamped = { .num_dft_waves = 10 };
+  LFSPARMS lfsparms;
+
+  /* The window keeps the default offset around the block */
+  g_assert_true (fpi_minutiae_profile_to_lfsparms (&blocksize_only, &lfsparms));
+  g_assert_cmpint (lfsparms.blocksize, ==, 12);
+  g_assert_cmpint (lfsparms.windowoffset, ==, g_lfsparms_V2.windowoffset);
+  g_assert_cmpint (lfsparms.windowsize, ==, 12 + 2 * g_lfsparms_V2.windowoffset);
+  g_assert_cmpint (lfsparms.trans_dir_pix, ==, 6);
+  g_assert_cmpint (lfsparms.inv_block_margin, ==, 6);
+
+  g_assert_true (fpi_minutiae_profile_to_lfsparms (&waves_only, &lfsparms));
+  g_assert_cmpint (lfsparms.num_dft_waves, ==, 3);
+  g_assert_cmpint (lfsparms.blocksize, ==, g_lfsparms_V2.blocksize);
+  g_assert_cmpint (lfsparms.windowsize, ==, g_lfsparms_V2.windowsize);
+
+  g_assert_true (fpi_minutiae_profile_to_lfsparms (&waves_clamped, &lfsparms));
+  g_assert_cmpint (lfsparms.num_dft_waves, ==, NUM_DFT_WAVES);
+}
+
+static void
+test_minutiae_profile_invalid (void)
+{
+  FpiMinutiaeProfile too_small = { .blocksize = 16, .windowsize = 8 };
+  FpiMinutiaeProfile odd_offset = { .blocksize = 16, .windowsize = 31 };
+  LFSPARMS lfsparms;
+
+  g_test_expect_message ("libfprint-image", G_LOG_LEVEL_WARNING,
+                         "*Invalid minutiae profile*");
+  g_assert_false (fpi_minutiae_profile_to_lfsparms (&too_small, &lfsparms));
+  g_test_assert_expected_messages ();
+  assert_lfsparms_default (&lfsparms);
+
+  g_test_expect_message ("libfprint-image", G_LOG_LEVEL_WARNING,
+                         "*Invalid minutiae profile*");
+  g_assert_false (fpi_minutiae_profile_to_lfsparms (&odd_offset, &lfsparms));
+  g_test_assert_expected_messages ();
+  assert_lfsparms_default (&lfsparms);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/image/minutiae_profile/default", test_minutiae_profile_default);
+  g_test_add_func ("/image/minutiae_profile/full", test_minutiae_profile_full);
+  g_test_add_func ("/image/minutiae_profile/partial", test_minutiae_profile_partial);
+  g_test_add_func ("/image/minutiae_profile/invalid", test_minutiae_profile_invalid);
+
+  return g_test_run ();
+}
@@ -0,0 +1,124 @@
+/*
+ * Unit tests for libfprint logging helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#define FP_COMPONENT "log"
+
+#include "fpi-log.h"
+
+static void
+test_log_debug_enabled (void)
+{
+  g_unsetenv ("G_MESSAGES_DEBUG");
+  g_assert_false (fpi_log_debug_enabled ("libfprint-log"));
+
+  g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+  g_assert_true (fpi_log_debug_enabled ("libfprint-log"));
+  g_assert_true (fpi_log_debug_enabled (NULL));
+
+  g_setenv ("G_MESSAGES_DEBUG", "libfprint-log", TRUE);
+  g_assert_true (fpi_log_debug_enabled ("libfprint-log"));
+  g_assert_false (fpi_log_debug_enabled ("libfprint"));
+  g_assert_false (fpi_log_debug_enabled (NULL));
+
+  g_setenv ("G_MESSAGES_DEBUG", "libfprint-device libfprint-log-extra", TRUE);
+  g_assert_true (fpi_log_debug_enabled ("libfprint-device"));
+  g_assert_false (fpi_log_debug_enabled ("libfprint-log"));
+
+  g_setenv ("G_MESSAGES_DEBUG", "libfprint-device,libfprint-log", TRUE);
+  g_assert_true (fpi_log_debug_enabled ("libfprint-log"));
+}
+
+static int evaluated;
+
+static int
+count_evaluation (void)
+{
+  return ++evaluated;
+}
+
+static void
+test_log_arguments_not_evaluated (void)
+{
+  int i;
+
+  /* The domain check is cached for the call site, the first call decides */
+  g_unsetenv ("G_MESSAGES_DEBUG");
+  evaluated = 0;
+
+  for (i = 0; i < 3; i++)
+    {
+      fp_dbg ("Not printed %d", count_evaluation ());
+
+      g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+    }
+
+  g_assert_cmpint (evaluated, ==, 0);
+}
+
+static void
+count_debug_messages (const gchar   *log_domain,
+                      GLogLevelFlags log_level,
+                      const gchar   *message,
+                      gpointer       user_data)
+{
+  int *printed = user_data;
+  g_autofree char *expected = NULL;
+
+  *printed += 1;
+  expected = g_strdup_printf ("Printed %d", *printed);
+  g_assert_cmpstr (message, ==, expected);
+}
+
+static void
+test_log_arguments_evaluated (void)
+{
+  int printed = 0;
+  guint handler;
+  int i;
+
+  g_setenv ("G_MESSAGES_DEBUG", G_LOG_DOMAIN, TRUE);
+  evaluated = 0;
+
+  handler = g_log_set_handler (G_LOG_DOMAIN, G_LOG_LEVEL_DEBUG,
+                               count_debug_messages, &printed);
+
+  /* Enabled on the first call, so later calls print despite the change */
+  for (i = 0; i < 3; i++)
+    {
+      fp_dbg ("Printed %d", count_evaluation ());
+
+      g_unsetenv ("G_MESSAGES_DEBUG");
+    }
+
+  g_log_remove_handler (G_LOG_DOMAIN, handler);
+
+  g_assert_cmpint (evaluated, ==, 3);
+  g_assert_cmpint (printed, ==, 3);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/log/debug_enabled", test_log_debug_enabled);
+  g_test_add_func ("/log/arguments_not_evaluated", test_log_arguments_not_evaluated);
+  g_test_add_func ("/log/arguments_evaluated", test_log_arguments_evaluated);
+
+  return g_test_run ();
+}
@@ -20,8 +20,10 @@
 #include "fp-device.h"
 #define FP_COMPONENT "SSM"
 
+#include <libfprint/fprint.h>
 #include "drivers_api.h"
 #include "test-device-fake.h"
+#include "test-utils.h"
 #include "fpi-log.h"
 
 /* Utility functions and shared data */
@@ -1311,6 +1313,76 @@ test_ssm_cleanup_fail (void)
   g_assert_true (data->ssm_destroyed);
 }
 
+static void
+test_ssm_stats (void)
+{
+  g_autoptr(GPtrArray) stats = NULL;
+  FpiSsmStats *ssm_stats;
+  FpiSsm *ssm;
+  guint i;
+
+  fpi_ssm_stats_set_enabled (TRUE);
+  fpi_ssm_stats_reset ();
+
+  for (i = 0; i < 2; i++)
+    {
+      g_autoptr(FpiSsmTestData) data = NULL;
+
+      ssm = ssm_test_new_full (FPI_TEST_SSM_STATE_NUM, FPI_TEST_SSM_STATE_NUM,
+                               "FPI_TEST_SSM_STATS");
+      data = fpi_ssm_test_data_ref (fpi_ssm_get_data (ssm));
+
+      fpi_ssm_start (ssm, test_ssm_completed_callback);
+      fpi_ssm_next_state_delayed (ssm, 10);
+
+      while (data->handler_state == FPI_TEST_SSM_STATE_0)
+        g_main_context_iteration (NULL, TRUE);
+
+      fpi_ssm_jump_to_state (ssm, FPI_TEST_SSM_STATE_3);
+      fpi_ssm_next_state (ssm);
+      g_assert_true (data->completed);
+    }
+
+  fpi_ssm_stats_set_enabled (FALSE);
+
+  stats = fpi_ssm_stats_get (fp_device_get_driver (fake_device));
+  ssm_stats = NULL;
+  for (i = 0; i < stats->len; i++)
+    if (g_str_equal (((FpiSsmStats *) g_ptr_array_index (stats, i))->name, "FPI_TEST_SSM_STATS"))
+      ssm_stats = g_ptr_array_index (stats, i);
+
+  g_assert_nonnull (ssm_stats);
+  g_assert_cmpint (ssm_stats->nr_states, ==, FPI_TEST_SSM_STATE_NUM);
+  g_assert_cmpuint (ssm_stats->delayed_transitions, ==, 2);
+  g_assert_cmpuint (ssm_stats->run.count, ==, 2);
+  g_assert_cmpuint (ssm_stats->states[FPI_TEST_SSM_STATE_0].count, ==, 2);
+  g_assert_cmpuint (ssm_stats->states[FPI_TEST_SSM_STATE_1].count, ==, 2);
+  g_assert_cmpuint (ssm_stats->states[FPI_TEST_SSM_STATE_2].count, ==, 0);
+  g_assert_cmpuint (ssm_stats->states[FPI_TEST_SSM_STATE_3].count, ==, 2);
+
+  /* The delayed transition keeps the machine in the first state */
+  g_assert_cmpint (ssm_stats->states[FPI_TEST_SSM_STATE_0].max_us, >=, 10 * 1000);
+  g_assert_cmpint (ssm_stats->run.total_us, >=,
+                   ssm_stats->states[FPI_TEST_SSM_STATE_0].total_us);
+
+  fpt_dump_ssm_stats (fp_device_get_driver (fake_device));
+
+  /* The returned entries are a snapshot */
+  fpi_ssm_stats_reset ();
+  g_assert_cmpuint (ssm_stats->run.count, ==, 2);
+
+  g_clear_pointer (&stats, g_ptr_array_unref);
+  stats = fpi_ssm_stats_get (fp_device_get_driver (fake_device));
+  ssm_stats = NULL;
+  for (i = 0; i < stats->len; i++)
+    if (g_str_equal (((FpiSsmStats *) g_ptr_array_index (stats, i))->name, "FPI_TEST_SSM_STATS"))
+      ssm_stats = g_ptr_array_index (stats, i);
+
+  g_assert_nonnull (ssm_stats);
+  g_assert_cmpuint (ssm_stats->run.count, ==, 0);
+  g_assert_cmpuint (ssm_stats->states[FPI_TEST_SSM_STATE_0].count, ==, 0);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1364,6 +1436,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/ssm/subssm/mark_failed", test_ssm_subssm_mark_failed);
   g_test_add_func ("/ssm/cleanup/complete", test_ssm_cleanup_complete);
   g_test_add_func ("/ssm/cleanup/fail", test_ssm_cleanup_fail);
+  g_test_add_func ("/ssm/stats", test_ssm_stats);
 
   return g_test_run ();
 }
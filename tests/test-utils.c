@@ -20,6 +20,7 @@
 #include <libfprint/fprint.h>
 #include <glib/gstdio.h>
 
+#include "fpi-ssm.h"
 #include "test-utils.h"
 
 struct
@@ -147,3 +148,49 @@ fpt_context_free (FptContext *tctx)
 
   fpt_teardown_virtual_device_environment ();
 }
+
+static void
+dump_histogram (GString *str, const char *label, const FpiSsmHistogram *histogram)
+{
+  guint i;
+
+  if (histogram->count == 0)
+    return;
+
+  g_string_append_printf (str, "  %-12s n=%u avg=%" G_GINT64_FORMAT "us max=%" G_GINT64_FORMAT "us |",
+                          label, histogram->count,
+                          histogram->total_us / histogram->count, histogram->max_us);
+
+  for (i = 0; i < FPI_SSM_HISTOGRAM_BUCKETS; i++)
+    g_string_append_printf (str, " %u", histogram->buckets[i]);
+
+  g_string_append_c (str, '\n');
+}
+
+void
+fpt_dump_ssm_stats (const char *driver)
+{
+  g_autoptr(GPtrArray) stats = fpi_ssm_stats_get (driver);
+  g_autoptr(GString) str = g_string_new (NULL);
+  guint i;
+  int state;
+
+  for (i = 0; i < stats->len; i++)
+    {
+      FpiSsmStats *ssm_stats = g_ptr_array_index (stats, i);
+
+      g_string_append_printf (str, "[%s] %s: %u delayed transitions\n",
+                              ssm_stats->driver, ssm_stats->name,
+                              ssm_stats->delayed_transitions);
+      dump_histogram (str, "run", &ssm_stats->run);
+
+      for (state = 0; state < ssm_stats->nr_states; state++)
+        {
+          g_autofree char *label = g_strdup_printf ("state %d", state);
+
+          dump_histogram (str, label, &ssm_stats->states[state]);
+        }
+    }
+
+  g_test_message ("SSM statistics:\n%s", str->str);
+}
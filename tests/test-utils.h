@@ -41,4 +41,6 @@ FptContext * fpt_context_new_with_virtual_device (FptVirtualDeviceType devtype);
 
 void fpt_context_free (FptContext *test_context);
 
+void fpt_dump_ssm_stats (const char *driver);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (FptContext, fpt_context_free)
@@ -16,6 +16,7 @@ try:
     import traceback
     import glob
     import tempfile
+    from contextlib import contextmanager
 except Exception as e:
     print("Missing dependencies: %s" % str(e))
     sys.exit(77)
@@ -1213,6 +1214,85 @@ class VirtualDeviceStorage(VirtualDevice):
                           'not-existing-print', False, identify=True)
 
 
+class VirtualDeviceContextIdentify(VirtualDeviceBase):
+
+    driver_name = 'virtual_device'
+    USE_CLASS_DEVICE = False
+
+    @classmethod
+    def setUpClass(cls):
+        super().setUpClass()
+        cls.storage_sockaddr = os.path.join(cls.tmpdir,
+            'virtual-device-storage.socket')
+        os.environ['FP_VIRTUAL_DEVICE_STORAGE'] = cls.storage_sockaddr
+
+    @classmethod
+    def tearDownClass(cls):
+        del os.environ['FP_VIRTUAL_DEVICE_STORAGE']
+        super().tearDownClass()
+
+    def setUp(self):
+        super().setUp()
+        self.storage_dev = None
+        for dev in self.ctx.get_devices():
+            if dev.get_driver() == 'virtual_device_storage':
+                self.storage_dev = dev
+        self.assertIsNotNone(self.storage_dev)
+        self.storage_dev.open_sync()
+
+    def tearDown(self):
+        with self.use_storage_device():
+            self.send_command('CONT')
+            self.dev.clear_storage_sync()
+            self.dev.close_sync()
+        del self.storage_dev
+        super().tearDown()
+
+    @contextmanager
+    def use_storage_device(self):
+        dev, sockaddr = self.dev, self.sockaddr
+        self.dev, self.sockaddr = self.storage_dev, self.storage_sockaddr
+        try:
+            yield
+        finally:
+            self.dev, self.sockaddr = dev, sockaddr
+
+    def test_identify_first_device_wins(self):
+        rt = self.enroll_print('right-thumb', FPrint.Finger.RIGHT_THUMB)
+        with self.use_storage_device():
+            lt = self.enroll_print('left-thumb', FPrint.Finger.LEFT_THUMB)
+            self.send_command('SCAN', 'left-thumb')
+
+        result = None
+        def identify_cb(ctx, res):
+            nonlocal result
+            try:
+                result = ctx.identify_finish(res)
+            except GLib.Error as e:
+                result = e
+
+        # Only the storage device gets a finger, the other device is
+        # still waiting for one and has to be cancelled.
+        self.ctx.identify([rt, lt], callback=identify_cb)
+        while result is None:
+            ctx.iteration(True)
+
+        self.assertNotIsInstance(result, Exception)
+        device, match, scanned = result
+        self.assertEqual(device, self.storage_dev)
+        self.assertIsNotNone(match)
+        self.assertTrue(match.equal(lt))
+        self.assertFalse(match.equal(rt))
+        self.assertEqual(scanned.props.fpi_data.unpack(), 'left-thumb')
+
+        # Both devices are idle again once the result is reported
+        self.assertEqual(self.dev.get_finger_status(),
+            FPrint.FingerStatusFlags.NONE)
+        self.check_verify([rt], 'right-thumb', identify=True, match=True)
+        with self.use_storage_device():
+            self.check_verify([lt], 'left-thumb', identify=True, match=True)
+
+
 if __name__ == '__main__':
     try:
         gi.require_version('FPrint', '2.0')
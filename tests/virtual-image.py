@@ -126,15 +126,22 @@ class VirtualImage(unittest.TestCase):
         while iterate and ctx.pending():
             ctx.iteration(False)
 
-    def send_image(self, image, iterate=True):
+    def send_allow_duplicates(self, allow, iterate=True):
+        # Set whether near duplicate enroll samples are accepted
+        self.con.sendall(struct.pack('ii', -6, 1 if allow else 0))
+        while iterate and ctx.pending():
+            ctx.iteration(False)
+
+    def send_image(self, image, iterate=True, skip_rows=0):
         img = self.prints[image]
 
         mem = img.get_data()
         mem = mem.tobytes()
         assert len(mem) == img.get_width() * img.get_height()
 
-        encoded_img = struct.pack('ii', img.get_width(), img.get_height())
-        encoded_img += mem
+        # Dropping rows gives a scan that is shifted against the full one
+        encoded_img = struct.pack('ii', img.get_width(), img.get_height() - skip_rows)
+        encoded_img += mem[skip_rows * img.get_width():]
 
         self.con.sendall(encoded_img)
         while iterate and ctx.pending():
@@ -318,6 +325,241 @@ class VirtualImage(unittest.TestCase):
         print(self._verify_error)
         assert(self._verify_error.matches(FPrint.device_error_quark(), FPrint.DeviceError.GENERAL))
 
+    def test_enroll_inconsistent(self):
+        self._step = 0
+        self._enrolled = None
+        self._progress = []
+
+        def progress_cb(dev, step, fp, error):
+            self._progress.append((step, fp, error))
+            self._step = step
+
+        def done_cb(dev, res):
+            self._enrolled = dev.enroll_finish(res)
+
+        template = FPrint.Print.new(self.dev)
+        self.dev.enroll(template, None, progress_cb, tuple(), done_cb)
+
+        self.send_image('whorl')
+        while len(self._progress) < 1:
+            ctx.iteration(True)
+        step, fp, error = self._progress[-1]
+        self.assertEqual(step, 1)
+        self.assertIsNone(error)
+        self.assertEqual(fp.get_enroll_quality(), (True, 1.0, 1.0))
+
+        # A different finger is rejected and does not complete a stage
+        self.send_image('tented_arch')
+        while len(self._progress) < 2:
+            ctx.iteration(True)
+        step, fp, error = self._progress[-1]
+        self.assertEqual(step, 1)
+        self.assertIsNone(fp)
+        assert(error.matches(FPrint.device_retry_quark(), FPrint.DeviceRetry.GENERAL))
+
+        self.send_image('whorl')
+        while len(self._progress) < 3:
+            ctx.iteration(True)
+        step, fp, error = self._progress[-1]
+        self.assertEqual(step, 2)
+        self.assertIsNone(error)
+        ok, consistency, coverage = fp.get_enroll_quality()
+        assert(ok)
+        self.assertEqual(consistency, 1.0)
+
+        for i in range(3, 6):
+            self.send_image('whorl')
+            while self._step < i:
+                ctx.iteration(True)
+        while self._enrolled is None:
+            ctx.iteration(True)
+        self.assertEqual(len(self._progress), 6)
+
+    def test_enroll_duplicates(self):
+        self._progress = []
+        self._cancelled = False
+        cancel = Gio.Cancellable()
+
+        def progress_cb(dev, step, fp, error):
+            self._progress.append((step, fp, error))
+
+        def done_cb(dev, res):
+            with self.assertRaises(GLib.GError) as cm:
+                dev.enroll_finish(res)
+            assert cm.exception.matches(Gio.io_error_quark(), Gio.IOErrorEnum.CANCELLED)
+            self._cancelled = True
+
+        def send_and_wait(image):
+            n = len(self._progress)
+            self.send_image(image)
+            while len(self._progress) == n:
+                ctx.iteration(True)
+            return self._progress[-1]
+
+        self.send_allow_duplicates(False)
+        try:
+            template = FPrint.Print.new(self.dev)
+            self.dev.enroll(template, cancel, progress_cb, tuple(), done_cb)
+
+            step, fp, error = send_and_wait('whorl')
+            self.assertEqual(step, 1)
+            self.assertIsNone(error)
+
+            # The same scan again is rejected a few times, then accepted
+            for i in range(3):
+                step, fp, error = send_and_wait('whorl')
+                self.assertEqual(step, 1)
+                self.assertIsNone(fp)
+                assert(error.matches(FPrint.device_retry_quark(), FPrint.DeviceRetry.CENTER_FINGER))
+
+            step, fp, error = send_and_wait('whorl')
+            self.assertEqual(step, 2)
+            self.assertIsNone(error)
+            self.assertEqual(fp.get_enroll_quality(), (True, 1.0, 0.0))
+
+            # A different finger is never accepted, however often it is tried
+            for i in range(5):
+                step, fp, error = send_and_wait('tented_arch')
+                self.assertEqual(step, 2)
+                self.assertIsNone(fp)
+                assert(error.matches(FPrint.device_retry_quark(), FPrint.DeviceRetry.GENERAL))
+
+            cancel.cancel()
+            while not self._cancelled:
+                ctx.iteration(True)
+        finally:
+            self.send_allow_duplicates(True)
+
+    def test_adaptive_update(self):
+        def verify_cb(dev, res):
+            r, fp = dev.verify_finish(res)
+            self._verify_match = r
+            self._verify_fp = fp
+
+        fp_whorl = self.enroll_print('whorl')
+        fp_data = fp_whorl.serialize()
+
+        # Prints are left alone by default
+        self.assertFalse(self.dev.props.adaptive_update)
+        self._verify_match = None
+        self.dev.verify(fp_whorl, callback=verify_cb)
+        self.send_image('whorl')
+        while self._verify_match is None:
+            ctx.iteration(True)
+        assert(self._verify_match)
+        # Only compare the print data, the usage statistics did change
+        assert fp_whorl.equal(FPrint.Print.deserialize(fp_data))
+
+        self.dev.props.adaptive_update = True
+        try:
+            self._verify_match = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('tented_arch')
+            while self._verify_match is None:
+                ctx.iteration(True)
+            assert(not self._verify_match)
+            assert fp_whorl.equal(FPrint.Print.deserialize(fp_data))
+
+            # The enrolled samples are identical, so use a shifted scan that
+            # still matches confidently but is not a copy of them
+            samples = self.print_samples(fp_whorl)
+            self._verify_match = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('whorl', skip_rows=16)
+            while self._verify_match is None:
+                ctx.iteration(True)
+            assert(self._verify_match)
+            assert not fp_whorl.equal(FPrint.Print.deserialize(fp_data))
+
+            # The scan was added or replaced a single sample
+            updated = self.print_samples(fp_whorl)
+            self.assertIn(len(updated), (len(samples), len(samples) + 1))
+            new_samples = [s for s in updated if s not in samples]
+            self.assertEqual(len(new_samples), 1)
+        finally:
+            self.dev.props.adaptive_update = False
+
+    def test_target_far(self):
+        def verify_cb(dev, res):
+            r, fp = dev.verify_finish(res)
+            self._verify_match = r
+            self._verify_fp = fp
+
+        fp_whorl = self.enroll_print('whorl')
+
+        self.assertEqual(self.dev.props.fpi_target_far, 0.0)
+        self.dev.props.fpi_target_far = 1e-5
+        try:
+            self.assertEqual(self.dev.props.fpi_target_far, 1e-5)
+
+            self._verify_match = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('whorl')
+            while self._verify_match is None:
+                ctx.iteration(True)
+            assert(self._verify_match)
+
+            self._verify_match = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('tented_arch')
+            while self._verify_match is None:
+                ctx.iteration(True)
+            assert(not self._verify_match)
+
+            # Rates beyond the calibration table do not make matching impossible
+            self.dev.props.fpi_target_far = 1e-12
+            self._verify_match = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('whorl')
+            while self._verify_match is None:
+                ctx.iteration(True)
+            assert(self._verify_match)
+        finally:
+            self.dev.props.fpi_target_far = 0.0
+
+    def test_extraction_time_budget(self):
+        def verify_cb(dev, res):
+            try:
+                self._verify_match, self._verify_fp = dev.verify_finish(res)
+            except gi.repository.GLib.Error as e:
+                self._verify_error = e
+
+        fp_whorl = self.enroll_print('whorl')
+
+        self.assertEqual(self.dev.props.extraction_time_budget, 0)
+        # In emulation every processing step counts as a millisecond, so
+        # the detection deterministically exceeds this budget
+        self.dev.props.extraction_time_budget = 1
+        try:
+            self._verify_fp = None
+            self._verify_error = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('whorl')
+            while self._verify_fp is None and self._verify_error is None:
+                ctx.iteration(True)
+            assert(self._verify_error.matches(FPrint.device_retry_quark(), FPrint.DeviceRetry.GENERAL))
+        finally:
+            self.dev.props.extraction_time_budget = 0
+
+        self._verify_match = None
+        self.dev.verify(fp_whorl, callback=verify_cb)
+        self.send_image('whorl')
+        while self._verify_match is None:
+            ctx.iteration(True)
+        assert(self._verify_match)
+
+        # A generous budget is never hit, as the steps are counted
+        self.dev.props.extraction_time_budget = 1000000
+        try:
+            self._verify_match = None
+            self.dev.verify(fp_whorl, callback=verify_cb)
+            self.send_image('whorl')
+            while self._verify_match is None:
+                ctx.iteration(True)
+            assert(self._verify_match)
+        finally:
+            self.dev.props.extraction_time_budget = 0
+
     def test_identify(self):
         done = False
 
@@ -406,6 +648,128 @@ class VirtualImage(unittest.TestCase):
             ctx.iteration(True)
         assert(not self._verify_match)
 
+    def test_usage_stats(self):
+        def verify_cb(dev, res):
+            r, fp = dev.verify_finish(res)
+            self._verify_match = r
+            self._verify_fp = fp
+
+        def identify_cb(dev, res):
+            self._identify_match, self._identify_fp = dev.identify_finish(res)
+
+        fp_whorl = self.enroll_print('whorl')
+        fp_tented_arch = self.enroll_print('tented_arch')
+
+        self.assertIsNone(fp_whorl.get_last_match())
+        self.assertEqual(fp_whorl.get_match_count(), 0)
+        self.assertEqual(fp_whorl.get_no_match_count(), 0)
+        self.assertEqual(fp_whorl.get_score_mean(), (False, 0.0))
+
+        self._verify_match = None
+        self.dev.verify(fp_whorl, callback=verify_cb)
+        self.send_image('whorl')
+        while self._verify_match is None:
+            ctx.iteration(True)
+        assert(self._verify_match)
+
+        self._verify_match = None
+        self.dev.verify(fp_whorl, callback=verify_cb)
+        self.send_image('tented_arch')
+        while self._verify_match is None:
+            ctx.iteration(True)
+        assert(not self._verify_match)
+
+        self.assertIsNotNone(fp_whorl.get_last_match())
+        self.assertEqual(fp_whorl.get_match_count(), 1)
+        self.assertEqual(fp_whorl.get_no_match_count(), 1)
+        ok, mean = fp_whorl.get_score_mean()
+        assert ok
+        assert mean > 0
+
+        # The statistics are kept when storing the print
+        fp_whorl_new = FPrint.Print.deserialize(fp_whorl.serialize())
+        self.assertEqual(fp_whorl_new.get_last_match().to_unix(),
+                         fp_whorl.get_last_match().to_unix())
+        self.assertEqual(fp_whorl_new.get_match_count(), 1)
+        self.assertEqual(fp_whorl_new.get_no_match_count(), 1)
+        self.assertEqual(fp_whorl_new.get_score_mean(), (True, mean))
+
+        # Identify only counts the matching print
+        self._identify_fp = None
+        self.dev.identify([fp_whorl_new, fp_tented_arch], callback=identify_cb)
+        self.send_image('tented_arch')
+        while self._identify_fp is None:
+            ctx.iteration(True)
+        assert(self._identify_match is fp_tented_arch)
+        self.assertEqual(fp_tented_arch.get_match_count(), 1)
+        self.assertEqual(fp_tented_arch.get_no_match_count(), 0)
+        self.assertEqual(fp_whorl_new.get_match_count(), 1)
+        self.assertEqual(fp_whorl_new.get_no_match_count(), 1)
+
+    def unpack_print(self, fp):
+        data = fp.serialize()
+        variant = GLib.Variant.new_from_bytes(
+            GLib.VariantType.new('(issbymsmsia{sv}v)'),
+            GLib.Bytes.new(data[3:]), False)
+        return data, list(variant.unpack())
+
+    def print_samples(self, fp):
+        # Returns the minutiae of each sample of fp as (xs, ys, thetas)
+        return [tuple(map(tuple, sample)) for sample in self.unpack_print(fp)[1][-1][0]]
+
+    def modify_print(self, fp, modify):
+        # Returns a copy of fp where the minutiae of the first sample were
+        # changed in place by modify(xs, ys, thetas)
+        data, fields = self.unpack_print(fp)
+        samples = [list(map(list, sample)) for sample in fields[-1][0]]
+        modify(*samples[0])
+        fields[-1] = GLib.Variant('(a(aiaiai))', (samples,))
+        types = {'last-match': 'x', 'score-mean': 'd'}
+        fields[-2] = {k: GLib.Variant(types.get(k, 'u'), v)
+                      for k, v in fields[-2].items()}
+        variant = GLib.Variant('(issbymsmsia{sv}v)', tuple(fields))
+        return FPrint.Print.deserialize(data[:3] + variant.get_data_as_bytes().get_data())
+
+    def test_identify_history(self):
+        def identify_cb(dev, res):
+            self._identify_match, self._identify_fp = dev.identify_finish(res)
+
+        def identify(gallery):
+            self._identify_fp = None
+            self.dev.identify(gallery, callback=identify_cb)
+            self.send_image('whorl')
+            while self._identify_fp is None:
+                ctx.iteration(True)
+            return self._identify_match
+
+        def collide(xs, ys, thetas):
+            # fpi_print_hash() mixes in x and then y with a factor of 31,
+            # so this keeps the hash while changing the print.
+            i = next(i for i, y in enumerate(ys) if y >= 31)
+            xs[i] += 1
+            ys[i] -= 31
+
+        def rotate(xs, ys, thetas):
+            thetas[0] = (thetas[0] + 1) % 360
+
+        fp_whorl = self.enroll_print('whorl')
+        fp_collision = self.modify_print(fp_whorl, collide)
+        fp_rotated = self.modify_print(fp_whorl, rotate)
+        assert not fp_collision.equal(fp_whorl)
+        assert not fp_rotated.equal(fp_whorl)
+
+        # All of them match the scan, so the order decides which one is
+        # reported.
+        for i in range(3):
+            assert identify([fp_collision]) is fp_collision
+
+        # A print with the same hash does not inherit its history
+        assert identify([fp_rotated, fp_whorl]) is fp_rotated
+
+        # The recently matched print is tried first
+        assert identify([fp_whorl, fp_rotated]) is fp_rotated
+        assert identify([fp_whorl, fp_rotated, fp_collision]) is fp_collision
+
 if __name__ == '__main__':
     try:
         gi.require_version('FPrint', '2.0')